@@ -19,6 +19,7 @@
 
 #include <config/fugax.hpp>
 #include <juro/promise.hpp>
+#include <juro/atomic-promise.hpp>
 #include <juro/compose/race.hpp>
 #include <utils/types.hpp>
 #include "event.hpp"
@@ -190,6 +191,20 @@ public:
      */
     event_listener always(event_handler functor);
 
+    /**
+     * @brief Returns a dispatcher that marshals tasks onto this loop: each
+     * dispatched task is scheduled for immediate execution
+     * @details Scheduling is protected by the loop mutex, so the returned
+     * dispatcher can be safely called from any thread. Supplying it to
+     * `juro::make_atomic()` makes the promise settle handlers execute in the
+     * thread that runs this loop.
+     * @warning The dispatcher refers to this loop without owning it: the loop
+     * must outlive every copy of the dispatcher, including the ones held by
+     * promises that were given it and have not been settled yet
+     * @return A new dispatcher bound to this loop
+     */
+    juro::dispatcher marshal();
+
     /**
      * @brief Creates a new promise that resolves after some time
      * @param delay The delay until the promise resolution
@@ -90,9 +90,16 @@ void event_loop::process(time_type now) {
         }
     }
 
+    std::lock_guard _ { mutex };
     counter = now;
 }
 
+juro::dispatcher event_loop::marshal() {
+    return [this] (std::function<void()> task) {
+        schedule(std::move(task));
+    };
+}
+
 juro::promise_ptr<fugax::timeout> event_loop::wait(time_type delay) {
     return juro::make_promise<fugax::timeout>([&] (const auto &promise) {
         schedule(delay, [=] { promise->resolve(); });
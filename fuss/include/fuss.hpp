@@ -9,27 +9,27 @@
 #ifndef FUSS_HPP
 #define FUSS_HPP
 
-#include <list>
+#include <functional>
 #include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "fuss/registry.hpp"
+
+#if __has_include(<config/fuss.hpp>)
+#include <config/fuss.hpp>
+#endif
+
+#ifdef FUSS_INSTRUMENTATION
+#include "fuss/instrumentation.hpp"
+#endif
 
 namespace fuss {
 
 template<class, class...>
 class shouter;
 
-/**
- * @brief Defines a generic cancellable interface
- */
-class cancellable {
-public:
-
-    /**
-     * @brief Should cancel a derived construct
-     */
-    virtual void cancel() = 0;
-    virtual ~cancellable() noexcept = default;
-};
-
 /**
  * @brief A message is a type-based contract
  * @tparam T_args The type signature of this message: any shouter must
@@ -40,127 +40,99 @@ public:
 template<class ...T_args>
 class message {  
 public:
-    class handler;
+    /**
+     * @brief The unique handler type for this specific message type
+     */
+    using handler = std::function<void(T_args...)>;
 
     /**
-     * @brief Each message type has a unique handler type; this aliases a list
-     * of that unique handler type
+     * @brief Each message type has a unique handler type; this aliases a
+     * registry of that unique handler type
      */
-    using handler_list = std::list<std::shared_ptr<handler>>;
+    using handler_registry = registry<handler>;
 
     /**
-     * @brief The unique handler type for this specific message type
+     * @brief A type able to store the arguments of this message type, so
+     * it can be delivered later
      */
-    class handler : public cancellable {
-        template<class, class...> friend class shouter;
-
-    protected:
-        /**
-         * @brief Keeps a reference of the list where this handler is stored for
-         * when the handler is unregistered
-         */
-        handler_list &source;
-
-        /**
-         * @brief An iterator that points to this element in a list
-         */
-        typename handler_list::iterator element;
-
-        /**
-         * @brief Creates a new message handler to be inserted in the provided list
-         * @param source The list that will contain this new handler
-         */
-        handler(handler_list &source) :
-            source { source },
-            element { source.end() }
-        {  }
-
-        /**
-         * @brief Message handler calling interface
-         * @param args The arguments with which to invoke this handler
-         */
-        virtual void operator()(T_args...args) = 0;
-
-    public:
-        virtual ~handler() noexcept = default;
-
-        /**
-         * @brief Cancels this handler by removing it from the list where it is
-         * stored
-         */
-        virtual void cancel() noexcept override {
-            if(element != source.end()) {
-                source.erase(element);
-                element = source.end();
-            }
-        }
-        
-    private:
-        /**
-         * @brief Informs the handler of where it was stored
-         * @param it The iterator that points to this handler
-         */
-        void attach(typename handler_list::iterator it) {
-            element = it;
-        }
-    };
+    using payload = std::tuple<std::decay_t<T_args>...>;
 
     /**
-     * @brief Stores the concrete implementation of a handler functor
-     * @tparam T The type of the functor wrapped by this object
+     * @brief Whether a functor can handle this message type
+     * @tparam T The type of the functor
      */
     template<class T>
-    class functor : public handler {
-        /**
-         * @brief This is the actual callable object that gets executed
-         */
-        T t;
-
-    public:
-        /**
-         * @brief Constructs a new wrapper around the supplied functor object
-         * @tparam T_func The type of the functor being wrapped
-         * @param source The list into which this functor will be placed
-         * @param func The functor to be wrapped
-         */
-        template<class T_func>
-        functor(handler_list &source, T_func &&func) : 
-            handler { source },
-            t { std::forward<T_func>(func) }
-        {  }
-
-        functor(const functor &)
-            noexcept(std::is_nothrow_copy_constructible_v<T>) = default;
-
-        functor(functor &&)
-            noexcept(std::is_nothrow_move_constructible_v<T>) = default;
-
-        functor &operator=(const functor &)
-            noexcept(std::is_nothrow_copy_assignable_v<T>) = default;
-
-        functor &operator=(functor &&)
-            noexcept(std::is_nothrow_move_assignable_v<T>) = default;
-
-        /**
-         * @brief Invokes the wrapped functor with the provided arguments
-         * @param args The arguments that will be forwarded to the functor
-         */
-        virtual void operator()(T_args ...args) override {
-            t(std::move(args)...);
-        }
-    };
+    static constexpr bool accepts = std::is_invocable_v<T &, T_args &...>;
 };
 
 /**
- * @brief A message listener keeps a weak pointer to a message handler attached
- * to a particular message shouter, so the subscription can be cancelled
- * safely anytime
+ * @brief A reference message is delivered by const reference: every handler
+ * gets a reference to the shouted arguments, so large payloads are never
+ * copied, no matter how many handlers there are
+ * @tparam T_args The type signature of this message
+ */
+template<class ...T_args>
+class ref_message : public message<const T_args &...> {  };
+
+/**
+ * @brief A keyed message is a message whose first argument is a key, e.g. a
+ * device identifier; shouters can then have handlers that are only invoked
+ * for a given key
+ * @tparam T_key The key type; must be hashable by `std::hash`
+ * @tparam T_args The rest of the type signature of this message
+ */
+template<class T_key, class ...T_args>
+class keyed_message : public message<const T_key &, T_args...> {
+public:
+    /**
+     * @brief The key type of this message type
+     */
+    using key_type = T_key;
+};
+
+/**
+ * @brief Tells whether a message type is keyed
+ * @tparam T The message type
+ */
+template<class T, class = void>
+struct is_keyed : std::false_type {  };
+
+template<class T>
+struct is_keyed<T, std::void_t<typename T::key_type>> : std::true_type {  };
+
+template<class T>
+inline constexpr bool is_keyed_v = is_keyed<T>::value;
+
+/**
+ * @brief The priority of a subscription: handlers with higher priorities are
+ * invoked first, and handlers with the same priority in subscription order
+ */
+struct priority {
+    /**
+     * @brief The priority value; subscriptions default to zero
+     */
+    int value = 0;
+};
+
+/**
+ * @brief A message listener identifies a message handler attached to a
+ * particular message shouter, so the subscription can be cancelled safely
+ * anytime, even after the handler has been cancelled or the shouter destroyed
+ * @details A listener is a pair of generation-checked indices: one that
+ * resolves the handler registry through the registry directory and one that
+ * locates the handler in the registry; copying and cancelling it involves no
+ * reference counting.
  */
 class listener {
     /**
-     * @brief Keeps a weak reference to the message handler
+     * @brief Identifies the handler registry
+     */
+    registry_id source;
+
+    /**
+     * @brief Identifies the handler in the registry
      */
-    std::weak_ptr<cancellable> handler;
+    handle target;
 
 public:
     /**
@@ -169,29 +141,53 @@ public:
     inline listener() noexcept = default;
 
     /**
-     * @brief Creates a new listener out a shared pointer to a handler
-     * @param handler A shared pointer to a handler object, cast to a
-     * cancellable interface
+     * @brief Creates a new listener out of a handler registry identifier and
+     * a handle
+     * @param source The identifier of the registry that stores the handler
+     * @param target The handle of the handler in the registry
      */
-    inline listener(const std::shared_ptr<cancellable> &handler) noexcept :
-        handler { handler }
+    inline listener(registry_id source, handle target) noexcept :
+        source { source },
+        target { target }
     {  }
 
-
     listener(const listener &) noexcept = default;
-    listener(listener &&) noexcept = default;
+
+    /**
+     * @brief Move constructor; the moved-from listener is left empty, so
+     * that it no longer refers to the handler
+     * @param other The listener to move from
+     */
+    inline listener(listener &&other) noexcept :
+        source { std::exchange(other.source, registry_id {  }) },
+        target { std::exchange(other.target, handle {  }) }
+    {  }
+
     virtual ~listener() noexcept = default;
 
     listener &operator=(const listener &) noexcept = default;
-    listener &operator=(listener &&) noexcept = default;
 
     /**
-     * @brief Attempts to lock the weak pointer and cancel the message
-     * handler by removing it from the shouter's handler list
+     * @brief Move assignment; the moved-from listener is left empty, so
+     * that it no longer refers to the handler
+     * @param other The listener to move from
+     * @return This listener
+     */
+    inline listener &operator=(listener &&other) noexcept {
+        if(this != &other) {
+            source = std::exchange(other.source, registry_id {  });
+            target = std::exchange(other.target, handle {  });
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Cancels the message handler by removing it from the shouter's
+     * handler registry, if both still exist
      */
     inline void cancel() const noexcept {
-        if(auto h = handler.lock()) {
-            h->cancel();
+        if(auto *registry = directory::find(source)) {
+            registry->cancel(target);
         }
     }
 };
@@ -211,7 +207,15 @@ public:
      * deleted
      */
     message_guard(const message_guard &) = delete;
-    message_guard(message_guard &&) noexcept = default;
+
+    /**
+     * @brief Move constructor; the moved-from guard is left empty, so its
+     * destruction does not cancel the subscription taken over by this one
+     * @param other The guard to move from
+     */
+    inline message_guard(message_guard &&other) noexcept :
+        fuss::listener { static_cast<fuss::listener &&>(other) }
+    {  }
 
     /**
      * @brief Converting constructor; allows to seemingly cast a message
@@ -236,7 +240,17 @@ public:
      * move-only objects
      */
     message_guard &operator=(const message_guard &) = delete;
-    message_guard &operator=(message_guard &&) noexcept = default;
+
+    /**
+     * @brief Move assignment; the moved-from guard is left empty, so its
+     * destruction does not cancel the subscription taken over by this one
+     * @param other The guard to move from
+     * @return This guard
+     */
+    inline message_guard &operator=(message_guard &&other) noexcept {
+        fuss::listener::operator=(static_cast<fuss::listener &&>(other));
+        return *this;
+    }
 
     /**
      * @brief Releases the guard: attempt to cancel the message handler
@@ -269,14 +283,91 @@ struct shouter : public shouter<T_message>, public shouter<T_rest ...> {
   using shouter<T_rest ...>::shout;
 };
 
+/**
+ * @brief Stores the handlers of a keyed message type that were attached for
+ * a specific key; empty for unkeyed message types
+ * @tparam T_message The message type
+ */
+template<class T_message, bool = is_keyed_v<T_message>>
+class keyed_index {  };
+
+/**
+ * @brief Stores the handlers of a keyed message type that were attached for
+ * a specific key, in a hash index from each key to its own registry, so
+ * shouting a key only touches the handlers attached for it
+ * @tparam T_message The message type
+ */
+template<class T_message>
+class keyed_index<T_message, true> {
+protected:
+    /**
+     * @brief The key type of the message
+     */
+    using key_type = typename T_message::key_type;
+
+    /**
+     * @brief Represents a registry of message handlers
+     */
+    using handler_registry = typename T_message::handler_registry;
+
+    /**
+     * @brief The registry of handlers attached for each key; registries are
+     * never moved, as map nodes are stable
+     */
+    std::unordered_map<key_type, handler_registry> index;
+
+    /**
+     * @brief Attaches a new handler for a key
+     * @tparam T The type of the handler functor
+     * @param key The key for which the handler is invoked
+     * @param t The handler functor
+     * @param order The priority of the handler
+     * @return A message listener that can be used to cancel this subscription
+     */
+    template<class T>
+    listener listen_key(const key_type &key, T &&t, priority order) {
+        auto &target = index.try_emplace(key).first->second;
+        auto h = target.add(std::forward<T>(t), order.value);
+        return { target.id(), h };
+    }
+
+    /**
+     * @brief Invokes the handlers attached for a key; once a key has no
+     * handlers left, it is removed from the index
+     * @tparam T_observer The type of the registry observer
+     * @tparam T_args The type of the rest of the arguments
+     * @param observer The registry observer
+     * @param key The shouted key
+     * @param args The rest of the arguments
+     */
+    template<class T_observer, class ...T_args>
+    void shout_key(const T_observer &observer, const key_type &key, T_args &&...args) {
+        auto found = index.find(key);
+        if(found == index.end()) return;
+
+        // Handlers may attach handlers for other keys, which can rehash the
+        // index but keeps references valid; a registry is only erased by the
+        // outermost shout of its key
+        auto &target = found->second;
+        target.observe(observer, key, std::forward<T_args>(args)...);
+
+        if(target.empty() && !target.dispatching()) {
+            index.erase(key);
+        }
+    }
+};
+
 /**
  * @brief A shouter is an actor that can broadcast messages containing
  * arbitrary data to interested parties, who react to the messages through
  * attached message handlers
+ * @details For keyed message types, handlers can also be attached for a
+ * single key. Shouting invokes the handlers attached for any key, then those
+ * attached for the shouted key.
  * @tparam T_message The type of the message this object can shout
  */
 template<class T_message>
-class shouter<T_message> {
+class shouter<T_message> : public keyed_index<T_message> {
 public:
     /**
      * @brief The type of the handler is provided by the message type
@@ -284,20 +375,15 @@ public:
     using handler = typename T_message::handler;
 
     /**
-     * @brief The type of the functor object is provided by the message type
-     */
-    template<class T> using functor = typename T_message::template functor<T>;
-
-    /**
-     * @brief Represents a list of message handlers
+     * @brief Represents a registry of message handlers
      */
-    using handler_list = typename T_message::handler_list;
+    using handler_registry = typename T_message::handler_registry;
 
     /**
-     * @brief The list of handlers registered at this shouter; whenever `.shout()`
-     * is called, each handler in this list will be invoked
+     * @brief The registry of handlers attached to this shouter; whenever
+     * `.shout()` is called, each handler in it will be invoked
      */
-    handler_list handlers;
+    handler_registry handlers;
 
 public:
 
@@ -310,22 +396,43 @@ public:
      * @tparam T The type of the functor to be executed when the message handler
      * is called
      * @param t The handler functor
+     * @param order The priority of the handler; handlers with higher
+     * priorities are invoked first
      * @return A message listener that can be used to cancel this subscription
      */
     template<class T_msg, class T>
     std::enable_if_t<std::is_same_v<T_message, T_msg>, listener>
-    listen(T &&t) {
-        auto func = 
-            std::make_shared<functor<std::decay_t<T>>>(handlers, std::forward<T>(t));
-        auto iterator = handlers.emplace(handlers.end(), std::move(func));
-        (*iterator)->attach(iterator);
+    listen(T &&t, priority order = {  }) {
+        auto target = handlers.add(std::forward<T>(t), order.value);
+        return { handlers.id(), target };
+    }
 
-        return std::static_pointer_cast<cancellable>(*iterator);
+    /**
+     * @brief Attaches a new message handler for a single key of a keyed
+     * message type and returns the message listener that represents this
+     * subscription
+     * @tparam T_msg The type of the message that is being listened to
+     * @tparam T_key The type of the key
+     * @tparam T The type of the handler functor
+     * @param key The key for which the handler is invoked
+     * @param t The handler functor
+     * @param order The priority of the handler among those of the same key
+     * @return A message listener that can be used to cancel this subscription
+     */
+    template<class T_msg, class T_key, class T>
+    std::enable_if_t<
+        std::is_same_v<T_message, T_msg> &&
+        is_keyed_v<T_msg> &&
+        T_msg::template accepts<std::decay_t<T>>,
+        listener
+    >
+    listen(T_key &&key, T &&t, priority order = {  }) {
+        return this->listen_key(std::forward<T_key>(key), std::forward<T>(t), order);
     }
 
     /**
      * @brief Broadcasts a message, calling each message handler in this shouter's
-     * list with the provided arguments
+     * registry with the provided arguments
      * @tparam T_msg The type of the message to shout; this parameter is used to
      * disambiguate between the multiple `.listen()` functions a single shouter
      * can have
@@ -335,8 +442,20 @@ public:
     template<class T_msg, class ...T_args>
     std::enable_if_t<std::is_same_v<T_message, T_msg>>
     shout(T_args &&...args) {
-        for(auto &handler : handlers) {
-            (*handler)(args...);
+#ifdef FUSS_INSTRUMENTATION
+        instrumentation::count_shout<T_message>();
+        const instrumentation::recorder observer {
+            instrumentation::catalog::of<T_message>()
+        };
+#else
+        const typename handler_registry::unobserved observer {  };
+#endif
+
+        if constexpr(is_keyed_v<T_message>) {
+            handlers.observe(observer, args...);
+            this->shout_key(observer, std::forward<T_args>(args)...);
+        } else {
+            handlers.observe(observer, std::forward<T_args>(args)...);
         }
     }
 };
@@ -365,16 +484,16 @@ struct group : public T_shouters... {
     }
 
     /**
-     * @brief Explicitly calls `shouter<T_message>::template listen<T_message>(T_functor)`
+     * @brief Explicitly calls `shouter<T_message>::template listen<T_message>(T_args...)`
      * @tparam T_message The type of the message for which to listen
-     * @tparam T_functor The type of the functor to forward to the shouter
-     * @param fun The functor object to be used in the handler constructor
+     * @tparam T_args The type of the arguments to forward to the shouter
+     * @param args The handler functor, preceded by a key for keyed messages
      * @return The message listener returned by the shouter
      */
-    template<class T_message, class T_functor>
-    auto listen(T_functor &&fun) {
+    template<class T_message, class ...T_args>
+    auto listen(T_args &&...args) {
         return shouter<T_message>::
-            template listen<T_message>(std::forward<T_functor>(fun));
+            template listen<T_message>(std::forward<T_args>(args)...);
     }
 };
 
@@ -0,0 +1,337 @@
+/**
+ * @file fuss/include/fuss/bus.hpp
+ * @brief Contains the definition of message buses, shouters that deliver
+ * messages asynchronously to handlers running on fugax event loops
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_BUS_HPP
+#define FUSS_BUS_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <fugax/event-loop.hpp>
+#include "fuss.hpp"
+#include "fuss/ring.hpp"
+
+namespace fuss {
+
+template<class, class...>
+class bus;
+
+/**
+ * @brief A bus is the cross-thread counterpart of a shouter: messages may be
+ * shouted from any thread and each handler is invoked in the event loop it
+ * declared when listening
+ * @attention this is a proxy type that can produce a single bus class for
+ * the message classes in <T_message, T_rest...>
+ * @tparam T_message The first message in the pack
+ * @tparam T_rest  The rest of the messages in the pack
+ */
+template<class T_message, class ...T_rest>
+struct bus : public bus<T_message>, public bus<T_rest...> {
+    using bus<T_message>::listen;
+    using bus<T_message>::shout;
+    using bus<T_rest...>::listen;
+    using bus<T_rest...>::shout;
+};
+
+/**
+ * @brief A bus is the cross-thread counterpart of a shouter: messages may be
+ * shouted from any thread and each handler is invoked in the event loop it
+ * declared when listening
+ * @details Handlers are grouped in stations, one for each event loop. Shouting
+ * a message stores its arguments once into the lock-free ring of each
+ * station, which is then drained by a single event scheduled in its loop;
+ * messages shouted before that event fires are delivered in the same batch,
+ * so the loop is only locked once per batch. Once the last handler of a
+ * station is cancelled, the station is retired: shouts stop reaching it and
+ * nothing is scheduled in its loop anymore.
+ * @note Handlers must be added and cancelled from the thread that runs the
+ * event loop they were attached to, and all of them must be cancelled before
+ * that loop is destroyed; shouting is safe from any thread.
+ * @tparam T_message The type of the message this object can shout
+ */
+template<class T_message>
+class bus<T_message> {
+public:
+    /**
+     * @brief The type of the handler is provided by the message type
+     */
+    using handler = typename T_message::handler;
+
+    /**
+     * @brief Represents a registry of message handlers
+     */
+    using handler_registry = typename T_message::handler_registry;
+
+    /**
+     * @brief The type in which shouted arguments are queued
+     */
+    using payload = typename T_message::payload;
+
+private:
+    struct hub;
+
+    /**
+     * @brief The handlers attached to an event loop, along with the messages
+     * queued for them
+     */
+    class station : public cancellable, public std::enable_shared_from_this<station> {
+    public:
+        /**
+         * @brief The state of the bus this station belongs to, which expires
+         * once the bus is gone
+         */
+        const std::weak_ptr<hub> owner;
+
+        /**
+         * @brief The loop in which handlers are invoked
+         */
+        fugax::event_loop &loop;
+
+        /**
+         * @brief The messages shouted and not yet delivered
+         */
+        ring<payload> queue;
+
+        /**
+         * @brief The handlers attached to this station
+         */
+        handler_registry handlers;
+
+        /**
+         * @brief Whether a drain has been scheduled and has not started yet
+         */
+        std::atomic<bool> armed = false;
+
+        /**
+         * @brief Whether the last handler has been cancelled; once set, the
+         * loop may be destroyed, so it is never scheduled in again
+         */
+        std::atomic<bool> retired = false;
+
+        /**
+         * @brief Serialises scheduling drains with retiring the station
+         */
+        std::mutex guard;
+
+        /**
+         * @brief The identifier through which listeners cancel handlers of
+         * this station
+         */
+        const registry_id self = directory::claim(this);
+
+        station(std::weak_ptr<hub> owner, fugax::event_loop &loop, std::size_t capacity) :
+            owner { std::move(owner) },
+            loop { loop },
+            queue { capacity }
+        {  }
+
+        ~station() noexcept override {
+            directory::release(self);
+        }
+
+        /**
+         * @brief Cancels a handler; retires the station if it was the last
+         */
+        void cancel(handle target) noexcept override {
+            handlers.cancel(target);
+            if(handlers.empty() && !retired.load()) {
+                {
+                    std::lock_guard lock { guard };
+                    retired.store(true);
+                }
+                // Keeps this station alive until it returns
+                const auto self_ref = this->shared_from_this();
+                if(const auto current = owner.lock()) current->remove(this);
+            }
+        }
+
+        /**
+         * @brief Schedules a drain in the station loop, unless one is
+         * already pending or the station has been retired
+         */
+        void arm() {
+            if(!armed.exchange(true)) {
+                std::lock_guard lock { guard };
+                if(retired.load()) return;
+
+                loop.schedule([self = this->shared_from_this()] {
+                    self->drain();
+                });
+            }
+        }
+
+        /**
+         * @brief Delivers every queued message to the attached handlers
+         */
+        void drain() {
+            armed.store(false);
+            try {
+                while(auto message = queue.try_pop()) {
+#ifdef FUSS_INSTRUMENTATION
+                    const instrumentation::recorder observer {
+                        instrumentation::catalog::of<T_message>()
+                    };
+#else
+                    const typename handler_registry::unobserved observer {  };
+#endif
+                    std::apply([&] (auto &...args) {
+                        handlers.observe(observer, std::move(args)...);
+                    }, *message);
+                }
+            } catch(...) {
+                arm();
+                throw;
+            }
+        }
+    };
+
+    /**
+     * @brief An immutable list of stations, replaced whenever a new station
+     * is created
+     */
+    using station_list = std::vector<std::shared_ptr<station>>;
+
+    /**
+     * @brief The state of the bus shared with its stations, which outlives
+     * the bus while a station is using it
+     */
+    struct hub {
+        /**
+         * @brief The current station list; loaded atomically by shouting
+         * threads
+         */
+        std::shared_ptr<const station_list> stations =
+            std::make_shared<const station_list>();
+
+        /**
+         * @brief Serialises the creation and removal of stations
+         */
+        std::mutex mutex;
+
+        /**
+         * @brief Removes a retired station from the station list
+         * @param retired The station
+         */
+        void remove(const station *retired) noexcept {
+            std::lock_guard lock { mutex };
+
+            const auto current = std::atomic_load(&stations);
+            auto next = std::make_shared<station_list>();
+            next->reserve(current->size());
+            for(auto &target : *current) {
+                if(target.get() != retired) next->push_back(target);
+            }
+            std::atomic_store(&stations, std::shared_ptr<const station_list> { next });
+        }
+    };
+
+    /**
+     * @brief The state shared with the stations
+     */
+    const std::shared_ptr<hub> shared = std::make_shared<hub>();
+
+    /**
+     * @brief How many messages each station can hold before being drained
+     */
+    const std::size_t capacity;
+
+public:
+    /**
+     * @brief Constructs a new bus
+     * @param capacity How many messages each station can hold before being
+     * drained; shouting to a full station fails
+     */
+    explicit bus(std::size_t capacity = 1024) : capacity { capacity } {  }
+
+    bus(const bus &) = delete;
+    bus(bus &&) = delete;
+
+    bus &operator=(const bus &) = delete;
+    bus &operator=(bus &&) = delete;
+
+    /**
+     * @brief Attaches a new message handler that is to be invoked in the
+     * supplied event loop and returns the listener that represents this
+     * subscription
+     * @tparam T_msg The type of the message that is being listened to; this
+     * parameter is used to disambiguate between the multiple `.listen()`
+     * functions a single bus can have
+     * @tparam T The type of the handler functor
+     * @param loop The event loop in which the handler is invoked; must be run
+     * by the calling thread
+     * @param t The handler functor
+     * @return A message listener that can be used to cancel this subscription
+     */
+    template<class T_msg, class T>
+    std::enable_if_t<std::is_same_v<T_message, T_msg>, listener>
+    listen(fugax::event_loop &loop, T &&t) {
+        auto target = station_for(loop);
+        auto h = target->handlers.add(std::forward<T>(t));
+        return { target->self, h };
+    }
+
+    /**
+     * @brief Broadcasts a message: its arguments are queued once for each
+     * event loop with attached handlers, which are invoked when the loop is
+     * next processed; may be called from any thread
+     * @tparam T_msg The type of the message to shout; this parameter is used to
+     * disambiguate between the multiple `.shout()` functions a single bus
+     * can have
+     * @tparam T_args The type of the shouted arguments
+     * @param args The arguments with which each handler will be invoked
+     * @return Whether the message was queued for every loop; it is not queued
+     * for loops whose stations are full
+     */
+    template<class T_msg, class ...T_args>
+    std::enable_if_t<std::is_same_v<T_message, T_msg>, bool>
+    shout(T_args &&...args) {
+#ifdef FUSS_INSTRUMENTATION
+        instrumentation::count_shout<T_message>();
+#endif
+        bool queued = true;
+        const auto current = std::atomic_load(&shared->stations);
+        for(auto &target : *current) {
+            if(target->retired.load()) continue;
+
+            if(target->queue.try_emplace(args...)) {
+                target->arm();
+            } else {
+                queued = false;
+            }
+        }
+        return queued;
+    }
+
+private:
+    /**
+     * @brief Finds the station of an event loop, creating it if needed
+     * @param loop The event loop
+     * @return The loop station
+     */
+    std::shared_ptr<station> station_for(fugax::event_loop &loop) {
+        std::lock_guard lock { shared->mutex };
+
+        const auto current = std::atomic_load(&shared->stations);
+        for(auto &target : *current) {
+            if(&target->loop == &loop) return target;
+        }
+
+        auto next = std::make_shared<station_list>(*current);
+        next->push_back(std::make_shared<station>(shared, loop, capacity));
+        std::atomic_store(&shared->stations, std::shared_ptr<const station_list> { next });
+        return next->back();
+    }
+};
+
+} /* namespace fuss */
+
+#endif /* FUSS_BUS_HPP */
@@ -0,0 +1,157 @@
+/**
+ * @file fuss/include/fuss/coalescing.hpp
+ * @brief Contains the definition of coalescing shouters, shouters that
+ * collapse bursts of messages into a single delivery of the latest one
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_COALESCING_HPP
+#define FUSS_COALESCING_HPP
+
+#include <optional>
+#include <tuple>
+#include <fugax/event-loop.hpp>
+#include "fuss.hpp"
+
+namespace fuss {
+
+/**
+ * @brief A coalescing shouter delivers messages with a latest-value-wins
+ * policy: shouting only stores the message arguments, replacing any not yet
+ * delivered, and handlers are invoked with the latest ones by an event
+ * scheduled in a fugax event loop
+ * @details The first message shouted after a delivery schedules the next
+ * one `interval` time units later, so handlers run at most once per interval
+ * no matter how many messages are shouted; with the default interval of zero,
+ * they run at most once per loop tick. Meant for high-frequency state updates
+ * where subscribers only care about the current state.
+ * @note Shouting, listening and processing the loop must happen in the same
+ * thread; use `fuss::bus` to shout from other threads.
+ * @tparam T_message The type of the message this object can shout
+ */
+template<class T_message>
+class coalescing {
+public:
+    /**
+     * @brief Represents a registry of message handlers
+     */
+    using handler_registry = typename T_message::handler_registry;
+
+    /**
+     * @brief The type in which shouted arguments are stored until delivered
+     */
+    using payload = typename T_message::payload;
+
+private:
+    /**
+     * @brief The loop in which messages are delivered
+     */
+    fugax::event_loop &loop;
+
+    /**
+     * @brief The minimum time between two deliveries
+     */
+    const fugax::time_type interval;
+
+    /**
+     * @brief The handlers attached to this shouter
+     */
+    handler_registry handlers;
+
+    /**
+     * @brief The latest arguments shouted and not yet delivered
+     */
+    std::optional<payload> latest;
+
+    /**
+     * @brief The pending delivery event, cancelled upon destruction
+     */
+    fugax::event_guard delivery;
+
+public:
+    /**
+     * @brief Constructs a new coalescing shouter
+     * @param loop The loop in which messages are delivered
+     * @param interval The minimum time between two deliveries
+     */
+    explicit coalescing(fugax::event_loop &loop, fugax::time_type interval = 0) :
+        loop { loop },
+        interval { interval }
+    {  }
+
+    coalescing(const coalescing &) = delete;
+    coalescing(coalescing &&) = delete;
+
+    coalescing &operator=(const coalescing &) = delete;
+    coalescing &operator=(coalescing &&) = delete;
+
+    /**
+     * @brief Attaches a new message handler and returns the message listener
+     * that represents this subscription
+     * @tparam T_msg The type of the message that is being listened to
+     * @tparam T The type of the handler functor
+     * @param t The handler functor
+     * @return A message listener that can be used to cancel this subscription
+     */
+    template<class T_msg, class T>
+    std::enable_if_t<std::is_same_v<T_message, T_msg>, listener>
+    listen(T &&t) {
+        auto target = handlers.add(std::forward<T>(t));
+        return { handlers.id(), target };
+    }
+
+    /**
+     * @brief Stores a message to be delivered, replacing any pending one, and
+     * schedules its delivery if none is scheduled yet
+     * @tparam T_msg The type of the message to shout
+     * @tparam T_args The type of the arguments
+     * @param args The arguments with which handlers will be invoked
+     */
+    template<class T_msg, class ...T_args>
+    std::enable_if_t<std::is_same_v<T_message, T_msg>>
+    shout(T_args &&...args) {
+#ifdef FUSS_INSTRUMENTATION
+        instrumentation::count_shout<T_message>();
+#endif
+        const bool scheduled = latest.has_value();
+        latest.emplace(std::forward<T_args>(args)...);
+
+        if(!scheduled) {
+            delivery = loop.schedule(interval, [this] { flush(); });
+        }
+    }
+
+    /**
+     * @brief Returns whether a message is waiting to be delivered
+     * @return Whether there is a pending message
+     */
+    inline bool pending() const noexcept { return latest.has_value(); }
+
+    /**
+     * @brief Delivers the pending message immediately, if there is one
+     */
+    void flush() {
+        if(!latest) return;
+
+        delivery.release();
+        auto current = std::move(*latest);
+        latest.reset();
+
+#ifdef FUSS_INSTRUMENTATION
+        const instrumentation::recorder observer {
+            instrumentation::catalog::of<T_message>()
+        };
+#else
+        const typename handler_registry::unobserved observer {  };
+#endif
+        std::apply([&] (auto &...args) {
+            handlers.observe(observer, std::move(args)...);
+        }, current);
+    }
+};
+
+} /* namespace fuss */
+
+#endif /* FUSS_COALESCING_HPP */
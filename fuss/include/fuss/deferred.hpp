@@ -0,0 +1,79 @@
+/**
+ * @file fuss/include/fuss/deferred.hpp
+ * @brief Contains a handler adaptor that defers handler execution onto a
+ * fugax event loop
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_DEFERRED_HPP
+#define FUSS_DEFERRED_HPP
+
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <fugax/event-loop.hpp>
+
+#if __has_include(<config/fuss.hpp>)
+#include <config/fuss.hpp>
+#endif
+
+#ifdef FUSS_INSTRUMENTATION
+#include "fuss/instrumentation.hpp"
+#endif
+
+namespace fuss {
+
+/**
+ * @brief Adapts a message handler so that, instead of running inside
+ * `.shout()`, it runs later in a fugax event loop, e.g. to keep slow,
+ * low-priority handlers from delaying latency-critical ones:
+ * `shouter.listen<msg>(fuss::deferred(loop, log), fuss::priority { -10 })`
+ * @details The shouted arguments are copied and a task invoking the handler
+ * with them is scheduled for immediate execution in the loop. Tasks still
+ * pending when the subscription is cancelled are skipped. When instrumented,
+ * each run is recorded into the statistics of the message whose dispatch
+ * scheduled it, under the same subscription.
+ * @tparam T_handler The type of the handler
+ * @param loop The loop in which the handler runs
+ * @param handler The handler
+ * @return The adapted handler, to be supplied to `.listen()`
+ */
+template<class T_handler>
+auto deferred(fugax::event_loop &loop, T_handler &&handler) {
+    auto target = std::make_shared<std::decay_t<T_handler>>(std::forward<T_handler>(handler));
+
+    return [&loop, target = std::move(target)] (const auto &...args) {
+#ifdef FUSS_INSTRUMENTATION
+        const auto *origin = instrumentation::invocation::current();
+#endif
+        loop.schedule([
+#ifdef FUSS_INSTRUMENTATION
+            origin = origin ? std::optional { *origin } : std::nullopt,
+#endif
+            handler = std::weak_ptr { target },
+            arguments = std::tuple<std::decay_t<decltype(args)>...> { args... }
+        ] () mutable {
+            if(auto current = handler.lock()) {
+#ifdef FUSS_INSTRUMENTATION
+                const auto start = std::chrono::steady_clock::now();
+                std::apply(*current, std::move(arguments));
+                if(origin) {
+                    origin->target->record_deferred(
+                        origin->identity,
+                        instrumentation::nanoseconds_since(start)
+                    );
+                }
+#else
+                std::apply(*current, std::move(arguments));
+#endif
+            }
+        });
+    };
+}
+
+} /* namespace fuss */
+
+#endif /* FUSS_DEFERRED_HPP */
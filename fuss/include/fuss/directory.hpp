@@ -0,0 +1,211 @@
+/**
+ * @file fuss/include/fuss/directory.hpp
+ * @brief Contains the definition of the registry directory, a process-wide
+ * table through which listeners reach the registries holding their handlers
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_DIRECTORY_HPP
+#define FUSS_DIRECTORY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace fuss {
+
+class cancellable;
+
+/**
+ * @brief Identifies a registry in the directory: an index into its table and
+ * the generation of that table entry when the registry claimed it; once the
+ * registry is destroyed, the generation is bumped and the identifier no
+ * longer resolves
+ */
+struct registry_id {
+    /**
+     * @brief The table index; defaults to an index no registry will ever have
+     */
+    std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @brief The generation of the entry at the time it was claimed
+     */
+    std::uint32_t generation = 0;
+};
+
+/**
+ * @brief The directory maps registry identifiers to live registries, so that
+ * listeners can reach a registry through a plain, trivially copyable
+ * identifier, and find out safely when it is gone, without reference counts
+ * @details The table grows in fixed-size chunks that are never moved, so
+ * resolving an identifier takes no lock. Claiming and releasing entries,
+ * which happens when registries are constructed and destroyed, takes no lock
+ * either: released entries are recycled through a lock-free free list, whose
+ * head is tagged with a counter to tell apart reuses of the same entry, and
+ * fresh entries are handed out by an atomic counter. Chunks are never freed,
+ * so identifiers of destroyed registries can always be resolved safely.
+ */
+class directory {
+    /**
+     * @brief How many entries each chunk holds
+     */
+    static constexpr std::uint32_t chunk_size = 4096;
+
+    /**
+     * @brief The maximum number of chunks
+     */
+    static constexpr std::uint32_t chunk_count = 4096;
+
+    /**
+     * @brief Marks the end of the free list
+     */
+    static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @brief A table entry; free entries are linked through `next_free`
+     */
+    struct entry {
+        std::atomic<cancellable *> owner = nullptr;
+        std::atomic<std::uint32_t> generation = 0;
+        std::atomic<std::uint32_t> next_free = none;
+    };
+
+    /**
+     * @brief The table chunks, allocated on demand
+     */
+    static inline std::array<std::atomic<entry *>, chunk_count> chunks {  };
+
+    /**
+     * @brief How many entries have ever been handed out fresh
+     */
+    static inline std::atomic<std::uint32_t> used = 0;
+
+    /**
+     * @brief The first free entry, in the low half, and the number of times
+     * the head has changed, in the high half
+     */
+    static inline std::atomic<std::uint64_t> free_head = none;
+
+    /**
+     * @brief Returns the table entry at an index, which must have been
+     * claimed at least once
+     */
+    static inline entry &at(std::uint32_t index) noexcept {
+        auto *chunk = chunks[index / chunk_size].load(std::memory_order_acquire);
+        return chunk[index % chunk_size];
+    }
+
+    /**
+     * @brief Packs an entry index and a tag into a free list head
+     */
+    static constexpr std::uint64_t pack(std::uint32_t index, std::uint64_t tag) noexcept {
+        return (tag << 32) | index;
+    }
+
+    /**
+     * @brief Pops an entry from the free list
+     * @return The entry index, or `none` if the list is empty
+     */
+    static std::uint32_t pop_free() noexcept {
+        auto head = free_head.load(std::memory_order_acquire);
+        while(static_cast<std::uint32_t>(head) != none) {
+            const auto index = static_cast<std::uint32_t>(head);
+            const auto next = at(index).next_free.load(std::memory_order_relaxed);
+            if(free_head.compare_exchange_weak(
+                head, pack(next, (head >> 32) + 1),
+                std::memory_order_acquire, std::memory_order_acquire
+            )) {
+                return index;
+            }
+        }
+        return none;
+    }
+
+    /**
+     * @brief Hands out an entry that was never claimed, allocating its chunk
+     * if no other thread has done so yet
+     * @return The entry index
+     * @throws std::length_error if the table is full
+     */
+    static std::uint32_t take_fresh() {
+        const auto index = used.fetch_add(1, std::memory_order_relaxed);
+        if(index >= chunk_size * chunk_count) {
+            used.fetch_sub(1, std::memory_order_relaxed);
+            throw std::length_error { "Too many live registries" };
+        }
+
+        auto &chunk = chunks[index / chunk_size];
+        if(!chunk.load(std::memory_order_acquire)) {
+            auto *fresh = new entry[chunk_size];
+            entry *expected = nullptr;
+            if(!chunk.compare_exchange_strong(
+                expected, fresh,
+                std::memory_order_acq_rel, std::memory_order_acquire
+            )) {
+                delete[] fresh;
+            }
+        }
+        return index;
+    }
+
+public:
+    /**
+     * @brief Claims a table entry for a registry
+     * @param owner The registry
+     * @return The identifier of the registry
+     */
+    static registry_id claim(cancellable *owner) {
+        auto index = pop_free();
+        if(index == none) index = take_fresh();
+
+        auto &target = at(index);
+        target.owner.store(owner, std::memory_order_release);
+        return { index, target.generation.load(std::memory_order_relaxed) };
+    }
+
+    /**
+     * @brief Releases the table entry of a registry being destroyed; its
+     * identifier no longer resolves afterwards
+     * @param id The identifier of the registry
+     */
+    static void release(registry_id id) noexcept {
+        auto &target = at(id.index);
+        target.generation.fetch_add(1, std::memory_order_acq_rel);
+        target.owner.store(nullptr, std::memory_order_release);
+
+        auto head = free_head.load(std::memory_order_relaxed);
+        do {
+            target.next_free.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+        } while(!free_head.compare_exchange_weak(
+            head, pack(id.index, (head >> 32) + 1),
+            std::memory_order_release, std::memory_order_relaxed
+        ));
+    }
+
+    /**
+     * @brief Resolves a registry identifier
+     * @param id The identifier
+     * @return The registry, or a null pointer if it has been destroyed
+     */
+    static cancellable *find(registry_id id) noexcept {
+        if(id.index >= chunk_size * chunk_count) return nullptr;
+
+        auto *chunk = chunks[id.index / chunk_size].load(std::memory_order_acquire);
+        if(!chunk) return nullptr;
+
+        auto &target = chunk[id.index % chunk_size];
+        if(target.generation.load(std::memory_order_acquire) != id.generation) {
+            return nullptr;
+        }
+        return target.owner.load(std::memory_order_acquire);
+    }
+};
+
+} /* namespace fuss */
+
+#endif /* FUSS_DIRECTORY_HPP */
@@ -0,0 +1,374 @@
+/**
+ * @file fuss/include/fuss/instrumentation.hpp
+ * @brief Contains the dispatch instrumentation of FUSS: per message type
+ * counters and timings, collected when `FUSS_INSTRUMENTATION` is defined
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_INSTRUMENTATION_HPP
+#define FUSS_INSTRUMENTATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include "fuss/registry.hpp"
+
+namespace fuss::instrumentation {
+
+/**
+ * @brief Returns a human-readable name of a type, without RTTI
+ * @tparam T The type
+ * @return The type name, as spelled by the compiler
+ */
+template<class T>
+constexpr std::string_view type_name() noexcept {
+#if defined(__clang__) || defined(__GNUC__)
+    constexpr std::string_view signature = __PRETTY_FUNCTION__;
+    constexpr auto start = signature.find("T = ") + 4;
+    constexpr auto end = signature.find_first_of(";]", start);
+    return signature.substr(start, end - start);
+#elif defined(_MSC_VER)
+    constexpr std::string_view signature = __FUNCSIG__;
+    constexpr auto start = signature.find("type_name<") + 10;
+    constexpr auto end = signature.rfind(">(void)");
+    return signature.substr(start, end - start);
+#else
+    return "unknown";
+#endif
+}
+
+/**
+ * @brief Identifies a subscription: the registry holding its handler and the
+ * generation-checked handle of the handler in it, so it stays unambiguous
+ * after the handler is cancelled and its slot reused
+ */
+struct subscriber {
+    /**
+     * @brief The registry holding the handler
+     */
+    registry_id registry;
+
+    /**
+     * @brief The handle of the handler in the registry
+     */
+    handle target;
+};
+
+/**
+ * @brief The slowest handler invocation of a message type
+ */
+struct slowest_handler {
+    /**
+     * @brief How long the invocation took, in nanoseconds
+     */
+    std::uint64_t time = 0;
+
+    /**
+     * @brief The subscription whose handler was invoked
+     */
+    subscriber identity;
+};
+
+/**
+ * @brief The dispatch statistics of a message type; counters are atomic, as
+ * messages may be dispatched from several threads
+ */
+struct statistics {
+    /**
+     * @brief The name of the message type
+     */
+    const std::string_view name;
+
+    /**
+     * @brief How many times the message has been shouted
+     */
+    std::atomic<std::uint64_t> shouts = 0;
+
+    /**
+     * @brief How many handlers the latest dispatch of the message reached
+     */
+    std::atomic<std::uint64_t> handlers = 0;
+
+    /**
+     * @brief How many times handlers have been invoked, over all dispatches
+     */
+    std::atomic<std::uint64_t> invocations = 0;
+
+    /**
+     * @brief The total time spent in handlers, in nanoseconds
+     */
+    std::atomic<std::uint64_t> total_time = 0;
+
+    /**
+     * @brief How many times deferred handlers have run in their loops
+     * @see `fuss::deferred()`
+     */
+    std::atomic<std::uint64_t> deferred_invocations = 0;
+
+    /**
+     * @brief The total time spent in deferred handlers, in nanoseconds
+     */
+    std::atomic<std::uint64_t> deferred_time = 0;
+
+    /**
+     * @brief The next statistics in the catalog
+     */
+    statistics *next = nullptr;
+
+    explicit statistics(std::string_view name) noexcept : name { name } {  }
+
+    /**
+     * @brief Returns the slowest handler invocation, deferred or not
+     * @return The time and the subscription of the invocation, read together
+     */
+    slowest_handler slowest() const {
+        std::lock_guard lock { mutex };
+        return slowest_invocation;
+    }
+
+    /**
+     * @brief Accounts for a handler invocation
+     * @param identity The subscription whose handler was invoked
+     * @param elapsed How long the invocation took, in nanoseconds
+     */
+    void record(subscriber identity, std::uint64_t elapsed) noexcept {
+        invocations.fetch_add(1, std::memory_order_relaxed);
+        total_time.fetch_add(elapsed, std::memory_order_relaxed);
+        record_slowest(identity, elapsed);
+    }
+
+    /**
+     * @brief Accounts for a deferred handler running in its loop
+     * @param identity The subscription whose handler ran
+     * @param elapsed How long it took, in nanoseconds
+     */
+    void record_deferred(subscriber identity, std::uint64_t elapsed) noexcept {
+        deferred_invocations.fetch_add(1, std::memory_order_relaxed);
+        deferred_time.fetch_add(elapsed, std::memory_order_relaxed);
+        record_slowest(identity, elapsed);
+    }
+
+    /**
+     * @brief Zeroes all counters
+     */
+    void reset() noexcept {
+        shouts.store(0, std::memory_order_relaxed);
+        handlers.store(0, std::memory_order_relaxed);
+        invocations.store(0, std::memory_order_relaxed);
+        total_time.store(0, std::memory_order_relaxed);
+        deferred_invocations.store(0, std::memory_order_relaxed);
+        deferred_time.store(0, std::memory_order_relaxed);
+
+        std::lock_guard lock { mutex };
+        slowest_invocation = {  };
+        slowest_hint.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Serialises updates of the slowest invocation, so its time and
+     * subscription always match
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * @brief The slowest invocation so far
+     */
+    slowest_handler slowest_invocation;
+
+    /**
+     * @brief The time of the slowest invocation, readable without locking,
+     * so that only invocations slower than it take the lock
+     */
+    std::atomic<std::uint64_t> slowest_hint = 0;
+
+    void record_slowest(subscriber identity, std::uint64_t elapsed) noexcept {
+        if(elapsed <= slowest_hint.load(std::memory_order_relaxed)) return;
+
+        std::lock_guard lock { mutex };
+        if(elapsed > slowest_invocation.time) {
+            slowest_invocation = { elapsed, identity };
+            slowest_hint.store(elapsed, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief The global catalog of dispatch statistics, with an entry for each
+ * message type that has been shouted at least once
+ */
+class catalog {
+    /**
+     * @brief The most recently added statistics; entries are linked through
+     * `statistics::next` and never removed
+     */
+    static inline std::atomic<statistics *> head = nullptr;
+
+public:
+    /**
+     * @brief Returns the statistics of a message type, adding them to the
+     * catalog on first use
+     * @tparam T_message The message type
+     * @return The message type statistics
+     */
+    template<class T_message>
+    static statistics &of() noexcept {
+        static statistics &instance = add(
+            *new statistics { type_name<T_message>() }
+        );
+        return instance;
+    }
+
+    /**
+     * @brief Visits the statistics of each message type in the catalog
+     * @tparam T_visitor The type of the visitor functor
+     * @param visitor A functor invoked with each `const statistics &`
+     */
+    template<class T_visitor>
+    static void for_each(T_visitor &&visitor) {
+        for(auto *current = head.load(std::memory_order_acquire); current; current = current->next) {
+            visitor(static_cast<const statistics &>(*current));
+        }
+    }
+
+    /**
+     * @brief Zeroes the counters of every message type
+     */
+    static void reset() noexcept {
+        for(auto *current = head.load(std::memory_order_acquire); current; current = current->next) {
+            current->reset();
+        }
+    }
+
+    /**
+     * @brief Writes the statistics of every message type, one per line
+     * @param stream The output stream
+     */
+    static void dump(std::ostream &stream) {
+        for_each([&] (const statistics &current) {
+            const auto slowest = current.slowest();
+            stream << current.name
+                << " shouts=" << current.shouts.load(std::memory_order_relaxed)
+                << " handlers=" << current.handlers.load(std::memory_order_relaxed)
+                << " invocations=" << current.invocations.load(std::memory_order_relaxed)
+                << " total_ns=" << current.total_time.load(std::memory_order_relaxed)
+                << " deferred_invocations=" << current.deferred_invocations.load(std::memory_order_relaxed)
+                << " deferred_ns=" << current.deferred_time.load(std::memory_order_relaxed)
+                << " slowest_ns=" << slowest.time
+                << " slowest_handler=" << slowest.identity.registry.index
+                << ':' << slowest.identity.target.slot
+                << ':' << slowest.identity.target.generation
+                << '\n';
+        });
+    }
+
+private:
+    /**
+     * @brief Links new statistics into the catalog
+     */
+    static statistics &add(statistics &added) noexcept {
+        auto *current = head.load(std::memory_order_relaxed);
+        do {
+            added.next = current;
+        } while(!head.compare_exchange_weak(current, &added, std::memory_order_release, std::memory_order_relaxed));
+        return added;
+    }
+};
+
+/**
+ * @brief The handler invocation in progress in the calling thread, which
+ * handler adaptors such as `fuss::deferred()` use to attribute the work they
+ * postpone to its message type and subscription
+ */
+struct invocation {
+    /**
+     * @brief The statistics of the message type being dispatched
+     */
+    statistics *target;
+
+    /**
+     * @brief The subscription whose handler is being invoked
+     */
+    subscriber identity;
+
+    /**
+     * @brief Returns the invocation in progress in the calling thread
+     * @return The invocation, or null if no instrumented handler is running
+     */
+    static const invocation *current() noexcept { return active; }
+
+private:
+    friend class recorder;
+
+    static inline thread_local const invocation *active = nullptr;
+};
+
+/**
+ * @brief Returns the time elapsed since a given instant, in nanoseconds
+ */
+inline std::uint64_t nanoseconds_since(std::chrono::steady_clock::time_point start) noexcept {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+    );
+}
+
+/**
+ * @brief A registry observer that times each handler invocation and records
+ * it into the statistics of a message type; one is used per dispatch and,
+ * once done, records how many handlers the dispatch reached
+ */
+class recorder {
+    statistics &target;
+    mutable std::uint64_t reached = 0;
+
+public:
+    explicit recorder(statistics &target) noexcept : target { target } {  }
+
+    recorder(const recorder &) = delete;
+    recorder(recorder &&) = delete;
+
+    recorder &operator=(const recorder &) = delete;
+    recorder &operator=(recorder &&) = delete;
+
+    ~recorder() noexcept {
+        target.handlers.store(reached, std::memory_order_relaxed);
+    }
+
+    template<class T_call>
+    void operator()(registry_id registry, handle current, T_call &&call) const {
+        const invocation running { &target, { registry, current } };
+
+        // Restores the enclosing invocation, should the handler shout again
+        struct scope {
+            const invocation *previous;
+            explicit scope(const invocation &running) noexcept :
+                previous { std::exchange(invocation::active, &running) } {  }
+            ~scope() noexcept { invocation::active = previous; }
+        } guard { running };
+
+        reached++;
+        const auto start = std::chrono::steady_clock::now();
+        call();
+        target.record(running.identity, nanoseconds_since(start));
+    }
+};
+
+/**
+ * @brief Counts a shout of a message type
+ * @tparam T_message The message type
+ */
+template<class T_message>
+inline void count_shout() noexcept {
+    catalog::of<T_message>().shouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+} /* namespace fuss::instrumentation */
+
+#endif /* FUSS_INSTRUMENTATION_HPP */
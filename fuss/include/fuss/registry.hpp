@@ -0,0 +1,459 @@
+/**
+ * @file fuss/include/fuss/registry.hpp
+ * @brief Contains the definition of handler registries, the dense containers
+ * where shouters store their message handlers
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_REGISTRY_HPP
+#define FUSS_REGISTRY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "fuss/directory.hpp"
+
+namespace fuss {
+
+/**
+ * @brief A handle identifies a handler stored in a registry. It is made of a
+ * slot, which locates the handler, and of the generation of that slot at the
+ * time the handler was stored; when a handler is removed, the generation of
+ * its slot is bumped, so any stale handles to it are safely ignored
+ */
+struct handle {
+    /**
+     * @brief The slot index; defaults to an index no registry will ever have
+     */
+    std::uint32_t slot = std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @brief The generation of the slot at the time the handle was issued
+     */
+    std::uint32_t generation = 0;
+};
+
+/**
+ * @brief Defines a generic cancellable interface
+ */
+class cancellable {
+public:
+
+    /**
+     * @brief Should cancel the construct identified by the supplied handle
+     * @param target The handle of the construct to cancel
+     */
+    virtual void cancel(handle target) noexcept = 0;
+    virtual ~cancellable() noexcept = default;
+};
+
+/**
+ * @brief A registry stores handlers contiguously, so they can be invoked by
+ * iterating over a dense array
+ * @details Handlers are kept sorted by priority, highest first, and in
+ * insertion order among equal priorities; the order is maintained when
+ * handlers are added, so dispatching never sorts. Removing a handler is O(1):
+ * its entry is turned into a tombstone, which is skipped during dispatch and
+ * discarded when the registry gets compacted, once tombstones outnumber live
+ * entries.
+ *
+ * Each dispatch, including nested ones, opens a dispatch epoch that lasts
+ * until the outermost dispatch returns or throws. Within an epoch the dense
+ * array is frozen: handlers added are held aside, handlers removed are only
+ * tombstoned and destroyed when the epoch closes. Handlers can therefore add
+ * and remove any handler, including themselves, and shout again while being
+ * invoked, without the handler array being copied on every dispatch.
+ * @tparam T_handler The type of the stored handlers
+ */
+template<class T_handler>
+class registry : public cancellable {
+    /**
+     * @brief Marks a tombstone entry or a free slot
+     */
+    static constexpr std::uint32_t vacant = std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @brief A handler and the slot that locates it
+     */
+    struct entry {
+        T_handler handler;
+        std::uint32_t slot;
+        int priority;
+    };
+
+    /**
+     * @brief Locates an entry; entries whose index is past the end of
+     * `entries` are in `incoming`
+     */
+    struct slot {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    /**
+     * @brief The stored handlers, in insertion order
+     */
+    std::vector<entry> entries;
+
+    /**
+     * @brief Handlers added during a dispatch, to be appended to `entries`
+     * once it finishes
+     */
+    std::vector<entry> incoming;
+
+    /**
+     * @brief The slot table, indexed by handle slots
+     */
+    std::vector<slot> slots;
+
+    /**
+     * @brief Slots that can be reused by new handlers
+     */
+    std::vector<std::uint32_t> free_slots;
+
+    /**
+     * @brief How many entries are tombstones
+     */
+    std::size_t tombstones = 0;
+
+    /**
+     * @brief How many dispatches are in progress; greater than one if a
+     * handler causes the registry to be dispatched again
+     */
+    std::size_t depth = 0;
+
+    /**
+     * @brief How many handlers were removed during the current dispatch
+     * epoch and still await destruction
+     */
+    std::size_t retired = 0;
+
+    /**
+     * @brief The identifier of this registry in the directory
+     */
+    const registry_id self = directory::claim(this);
+
+    /**
+     * @brief RAII-style marker of an ongoing dispatch; when the outermost
+     * dispatch finishes, whether normally or by an exception, the dispatch
+     * epoch closes and the registry gets settled
+     */
+    class dispatch_scope {
+        registry &owner;
+
+    public:
+        inline explicit dispatch_scope(registry &owner) noexcept : owner { owner } {
+            owner.depth++;
+        }
+
+        inline ~dispatch_scope() {
+            if(--owner.depth == 0) {
+                owner.settle();
+            }
+        }
+    };
+
+public:
+    registry() = default;
+    registry(const registry &) = delete;
+    registry(registry &&) = delete;
+
+    registry &operator=(const registry &) = delete;
+    registry &operator=(registry &&) = delete;
+
+    /**
+     * @brief Upon destruction, the registry identifier stops resolving, so
+     * any outstanding listeners are safely ignored
+     */
+    ~registry() noexcept override {
+        directory::release(self);
+    }
+
+    /**
+     * @brief Returns the identifier of this registry in the directory
+     * @return The registry identifier
+     */
+    inline registry_id id() const noexcept { return self; }
+
+    /**
+     * @brief Stores a new handler
+     * @details Adding a handler with a priority no higher than that of the
+     * last stored handler is O(1); otherwise, later handlers are shifted.
+     * @tparam T The type of the handler, or of a functor it can be constructed
+     * from
+     * @param handler The handler
+     * @param priority The handler priority; handlers with higher priorities
+     * are invoked first
+     * @return A handle that identifies the handler in this registry
+     */
+    template<class T>
+    handle add(T &&handler, int priority = 0) {
+        T_handler created { std::forward<T>(handler) };
+
+        std::uint32_t index;
+        if(free_slots.empty()) {
+            index = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({ vacant, 0 });
+            free_slots.reserve(slots.size());
+        } else {
+            index = free_slots.back();
+            free_slots.pop_back();
+        }
+
+        if(depth > 0) {
+            incoming.push_back({ std::move(created), index, priority });
+            slots[index].index =
+                static_cast<std::uint32_t>(entries.size() + incoming.size() - 1);
+        } else if(entries.empty() || entries.back().priority >= priority) {
+            entries.push_back({ std::move(created), index, priority });
+            slots[index].index = static_cast<std::uint32_t>(entries.size() - 1);
+        } else {
+            const auto position = std::upper_bound(
+                entries.begin(), entries.end(), priority,
+                [] (int value, const entry &current) {
+                    return value > current.priority;
+                }
+            );
+            const auto first = static_cast<std::size_t>(position - entries.begin());
+            entries.insert(position, { std::move(created), index, priority });
+            reindex(first);
+        }
+
+        return { index, slots[index].generation };
+    }
+
+    /**
+     * @brief Removes a handler; does nothing if the handle is stale
+     * @param target The handle of the handler to remove
+     */
+    void cancel(handle target) noexcept override {
+        if(!contains(target)) return;
+
+        auto &info = slots[target.slot];
+        auto &removed = locate(info.index);
+        const bool frozen = depth > 0 && info.index < entries.size();
+        removed.slot = vacant;
+        tombstones++;
+
+        info.index = vacant;
+        info.generation++;
+        free_slots.push_back(target.slot);
+
+        // The removed handler may be the one being invoked, so during a
+        // dispatch epoch its destruction is left to `settle()`
+        if(frozen) {
+            retired++;
+            return;
+        }
+
+        // Destroyed last, as its destructor may reenter the registry
+        auto released = std::move(removed.handler);
+        removed.handler = T_handler {  };
+
+        if(depth == 0 && tombstones > entries.size() / 2) {
+            settle();
+        }
+    }
+
+    /**
+     * @brief Checks whether a handle refers to a handler in this registry
+     * @param target The handle to check
+     * @return Whether the handle is valid
+     */
+    inline bool contains(handle target) const noexcept {
+        return target.slot < slots.size() &&
+            slots[target.slot].generation == target.generation &&
+            slots[target.slot].index != vacant;
+    }
+
+    /**
+     * @brief Returns how many handlers are stored
+     * @return The number of live handlers
+     */
+    inline std::size_t size() const noexcept {
+        return entries.size() + incoming.size() - tombstones;
+    }
+
+    /**
+     * @brief Returns whether there are no handlers stored
+     * @return Whether the registry is empty
+     */
+    inline bool empty() const noexcept { return size() == 0; }
+
+    /**
+     * @brief Returns whether the registry is being dispatched
+     * @return Whether a dispatch epoch is open
+     */
+    inline bool dispatching() const noexcept { return depth > 0; }
+
+    /**
+     * @brief Invokes each stored handler, in insertion order, with the
+     * supplied arguments; handlers added during the dispatch are not invoked
+     * and handlers removed during the dispatch are not invoked after removal
+     * @details Handlers receive the arguments as lvalues, except the last
+     * one, to which they are forwarded: rvalue arguments are then moved into
+     * it rather than copied.
+     * @tparam T_args The types of the arguments
+     * @param args The arguments with which to invoke every handler
+     */
+    template<class ...T_args>
+    inline void dispatch(T_args &&...args) {
+        observe(unobserved {  }, std::forward<T_args>(args)...);
+    }
+
+    /**
+     * @brief Dispatches the registry like `.dispatch()`, but lets an observer
+     * wrap each handler invocation, e.g. to time it
+     * @tparam T_observer The type of the observer; it is invoked with the id of
+     * this registry, the handle of each handler and a nullary functor that
+     * invokes it
+     * @tparam T_args The types of the arguments
+     * @param observer The observer
+     * @param args The arguments with which to invoke every handler
+     */
+    template<class T_observer, class ...T_args>
+    void observe(T_observer &&observer, T_args &&...args) {
+        dispatch_scope scope { *this };
+
+        auto count = entries.size();
+        while(count > 0 && entries[count - 1].slot == vacant) {
+            count--;
+        }
+        if(count == 0) return;
+
+        for(std::size_t i = 0; i < count - 1; i++) {
+            auto &current = entries[i];
+            if(current.slot != vacant) {
+                observer(self, handle_of(current), [&] { current.handler(args...); });
+            }
+        }
+
+        auto &last = entries[count - 1];
+        if(last.slot != vacant) {
+            observer(self, handle_of(last), [&] {
+                last.handler(std::forward<T_args>(args)...);
+            });
+        }
+    }
+
+    /**
+     * @brief The default observer, which just invokes each handler
+     */
+    struct unobserved {
+        template<class T_call>
+        inline void operator()(registry_id, handle, T_call &&call) const { call(); }
+    };
+
+private:
+    /**
+     * @brief Returns the handle of a live entry
+     */
+    inline handle handle_of(const entry &target) const noexcept {
+        return { target.slot, slots[target.slot].generation };
+    }
+
+    /**
+     * @brief Returns the entry stored at an index
+     * @param index The index of the entry, possibly past the end of `entries`
+     * @return A reference to the entry
+     */
+    inline entry &locate(std::uint32_t index) noexcept {
+        return index < entries.size() ?
+            entries[index] :
+            incoming[index - entries.size()];
+    }
+
+    /**
+     * @brief Closes a dispatch epoch: moves handlers added during it to the
+     * dense array and compacts it, if needed or if handlers removed during it
+     * are still to be destroyed
+     */
+    void settle() {
+        do {
+            const auto first = entries.size();
+            for(auto &added : incoming) {
+                entries.push_back(std::move(added));
+            }
+            incoming.clear();
+
+            const auto by_priority = [] (const entry &left, const entry &right) {
+                return left.priority > right.priority;
+            };
+            if(!std::is_sorted(entries.begin(), entries.end(), by_priority)) {
+                std::stable_sort(entries.begin() + first, entries.end(), by_priority);
+                std::inplace_merge(
+                    entries.begin(), entries.begin() + first, entries.end(), by_priority
+                );
+                reindex(0);
+            }
+
+            if(retired > 0 || tombstones > entries.size() / 2) {
+                compact();
+            }
+        } while(!incoming.empty());
+    }
+
+    /**
+     * @brief Updates the slots of the live entries from a position onwards,
+     * after they have been moved
+     * @param first The first moved position
+     */
+    void reindex(std::size_t first) noexcept {
+        for(auto i = first; i < entries.size(); i++) {
+            if(entries[i].slot != vacant) {
+                slots[entries[i].slot].index = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+
+    /**
+     * @brief Destroys the handlers of all tombstones, then discards them,
+     * preserving the order of live entries
+     */
+    void compact() {
+        // Destroying handlers runs arbitrary code that may add or remove
+        // handlers, so it happens within a dispatch epoch of its own
+        depth++;
+        do {
+            retired = 0;
+            for(auto &current : entries) {
+                if(current.slot == vacant && current.handler) {
+                    auto released = std::move(current.handler);
+                    current.handler = T_handler {  };
+                }
+            }
+        } while(retired > 0);
+        depth--;
+
+        std::size_t last = 0;
+        for(std::size_t i = 0; i < entries.size(); i++) {
+            if(entries[i].slot == vacant) continue;
+            if(i != last) {
+                entries[last] = std::move(entries[i]);
+            }
+            slots[entries[last].slot].index = static_cast<std::uint32_t>(last);
+            last++;
+        }
+
+        entries.resize(last);
+        tombstones = 0;
+
+        // Handlers added while destroying others are located past the end
+        // of the dense array, which has just shrunk
+        for(std::size_t i = 0; i < incoming.size(); i++) {
+            if(incoming[i].slot == vacant) {
+                tombstones++;
+            } else {
+                slots[incoming[i].slot].index =
+                    static_cast<std::uint32_t>(entries.size() + i);
+            }
+        }
+    }
+};
+
+} /* namespace fuss */
+
+#endif /* FUSS_REGISTRY_HPP */
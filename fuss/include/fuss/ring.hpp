@@ -0,0 +1,163 @@
+/**
+ * @file fuss/include/fuss/ring.hpp
+ * @brief Contains the definition of a bounded lock-free queue, used to hand
+ * messages across threads
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_RING_HPP
+#define FUSS_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace fuss {
+
+/**
+ * @brief A bounded, lock-free, multiple-producer single-consumer queue
+ * @details Each cell carries a sequence number that tells producers and
+ * consumers whether it is free for writing or ready for reading, so claiming
+ * a position is a single compare-and-swap and no thread ever waits for
+ * another. The capacity is rounded up to a power of two.
+ * @tparam T The type of the queued elements
+ */
+template<class T>
+class ring {
+    /**
+     * @brief A queue position; the value is empty only if its construction
+     * threw, in which case it is skipped by the consumer
+     */
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        std::optional<T> value;
+    };
+
+    /**
+     * @brief Rounds a capacity up to a power of two
+     */
+    static constexpr std::size_t round_up(std::size_t capacity) noexcept {
+        std::size_t result = 1;
+        while(result < capacity) result <<= 1;
+        return result;
+    }
+
+    /**
+     * @brief The cell array, indexed by positions masked by `mask`
+     */
+    const std::unique_ptr<cell[]> cells;
+
+    /**
+     * @brief The capacity minus one
+     */
+    const std::size_t mask;
+
+    /**
+     * @brief The next position to be written; kept apart from `head` to avoid
+     * false sharing between producers and the consumer
+     */
+    alignas(64) std::atomic<std::size_t> tail = 0;
+
+    /**
+     * @brief The next position to be read
+     */
+    alignas(64) std::atomic<std::size_t> head = 0;
+
+public:
+    /**
+     * @brief Constructs an empty ring
+     * @param capacity The minimum number of elements the ring must hold
+     */
+    explicit ring(std::size_t capacity) :
+        cells { std::make_unique<cell[]>(round_up(capacity)) },
+        mask { round_up(capacity) - 1 }
+    {
+        for(std::size_t i = 0; i <= mask; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ring(const ring &) = delete;
+    ring(ring &&) = delete;
+
+    ring &operator=(const ring &) = delete;
+    ring &operator=(ring &&) = delete;
+
+    /**
+     * @brief Returns how many elements the ring can hold
+     * @return The ring capacity
+     */
+    inline std::size_t capacity() const noexcept { return mask + 1; }
+
+    /**
+     * @brief Attempts to construct a new element at the back of the queue;
+     * may be called from any thread
+     * @tparam T_args The types of the arguments
+     * @param args The arguments from which to construct the element
+     * @return Whether there was room for the element
+     */
+    template<class ...T_args>
+    bool try_emplace(T_args &&...args) {
+        auto position = tail.load(std::memory_order_relaxed);
+        cell *target;
+        for(;;) {
+            target = &cells[position & mask];
+            const auto sequence = target->sequence.load(std::memory_order_acquire);
+            const auto difference =
+                static_cast<std::intptr_t>(sequence) -
+                static_cast<std::intptr_t>(position);
+
+            if(difference == 0) {
+                if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        try {
+            target->value.emplace(std::forward<T_args>(args)...);
+        } catch(...) {
+            target->sequence.store(position + 1, std::memory_order_release);
+            throw;
+        }
+        target->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Attempts to remove the element at the front of the queue; must
+     * be called from a single thread at a time
+     * @return The removed element, or an empty optional if the queue is empty
+     */
+    std::optional<T> try_pop() {
+        for(;;) {
+            const auto position = head.load(std::memory_order_relaxed);
+            auto &target = cells[position & mask];
+            const auto sequence = target.sequence.load(std::memory_order_acquire);
+            if(sequence != position + 1) {
+                return std::nullopt;
+            }
+
+            head.store(position + 1, std::memory_order_relaxed);
+            auto result = std::move(target.value);
+            target.value.reset();
+            target.sequence.store(position + mask + 1, std::memory_order_release);
+
+            if(result) {
+                return result;
+            }
+        }
+    }
+};
+
+} /* namespace fuss */
+
+#endif /* FUSS_RING_HPP */
@@ -0,0 +1,85 @@
+/**
+ * @file fuss/include/fuss/static-shouter.hpp
+ * @brief Contains the definition of static shouters, shouters whose handlers
+ * are fixed at compile time
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#ifndef FUSS_STATIC_SHOUTER_HPP
+#define FUSS_STATIC_SHOUTER_HPP
+
+#include <tuple>
+#include <type_traits>
+#include "fuss.hpp"
+
+namespace fuss {
+
+/**
+ * @brief A static shouter broadcasts a message to a set of handlers that is
+ * fixed at compile time
+ * @details Handlers are stored by value, in a tuple, and invoked in order
+ * through their concrete types, so shouting involves no type erasure, no
+ * virtual calls and no allocations, and can be inlined into the handler
+ * bodies; it can even happen in constant expressions. In exchange, handlers
+ * can be neither added nor cancelled after construction. Use
+ * `fuss::make_static_shouter()` to have handler types deduced.
+ * @tparam T_message The type of the message this object can shout
+ * @tparam T_handlers The types of the handlers
+ */
+template<class T_message, class ...T_handlers>
+class static_shouter {
+    static_assert(
+        (T_message::template accepts<T_handlers> && ...),
+        "Every handler must be able to handle the message type"
+    );
+
+    /**
+     * @brief The handlers, invoked in order whenever `.shout()` is called
+     */
+    std::tuple<T_handlers...> handlers;
+
+public:
+    /**
+     * @brief Constructs a new static shouter
+     * @param handlers The handlers to which messages are shouted
+     */
+    constexpr explicit static_shouter(T_handlers ...handlers) :
+        handlers { std::move(handlers)... }
+    {  }
+
+    /**
+     * @brief Broadcasts a message, calling each handler with the provided
+     * arguments
+     * @tparam T_msg The type of the message to shout; taken for consistency
+     * with `fuss::shouter`
+     * @tparam T_args The type of the arguments
+     * @param args The arguments used to call each handler
+     */
+    template<class T_msg, class ...T_args>
+    constexpr std::enable_if_t<std::is_same_v<T_message, T_msg>>
+    shout(T_args &&...args) {
+        std::apply([&] (auto &...handler) {
+            (handler(args...), ...);
+        }, handlers);
+    }
+};
+
+/**
+ * @brief Creates a static shouter, deducing the handler types
+ * @tparam T_message The type of the message the shouter can shout
+ * @tparam T_handlers The types of the handlers
+ * @param handlers The handlers to which messages are shouted
+ * @return The static shouter
+ */
+template<class T_message, class ...T_handlers>
+constexpr auto make_static_shouter(T_handlers &&...handlers) {
+    return static_shouter<T_message, std::decay_t<T_handlers>...> {
+        std::forward<T_handlers>(handlers)...
+    };
+}
+
+} /* namespace fuss */
+
+#endif /* FUSS_STATIC_SHOUTER_HPP */
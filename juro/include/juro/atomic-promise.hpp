@@ -0,0 +1,382 @@
+/**
+ * @file juro/atomic-promise.hpp
+ * @brief Contains the definition of atomic promises, promises that can be
+ * settled from a thread other than the one attaching their settle handler
+ * @author André Medeiros
+*/
+
+#ifndef JURO_ATOMIC_PROMISE_HPP
+#define JURO_ATOMIC_PROMISE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <variant>
+#include "juro/promise.hpp"
+
+namespace juro {
+
+/**
+ * @brief An atomic promise is the thread-safe counterpart of `juro::promise`.
+ * @details Regular promises are not synchronised: settling one in a thread
+ * while attaching its settle handler in another is a data race. An atomic
+ * promise solves this with a lock-free handshake: both the settling and the
+ * attaching sides publish their work through a single atomic flag set and
+ * whichever side finishes last is responsible for firing the settle handler.
+ *
+ * Settle handlers are attached to an internal regular promise, so everything
+ * down the chain consists of regular promises. Since those must not be
+ * touched from two threads at once, the internal promise is always settled
+ * through a dispatcher, e.g. in an event loop running in the thread that
+ * consumes the result, and never in whichever thread completes the handshake.
+ * @note An atomic promise can be settled from any thread, but only one
+ * settle handler can be attached, from a single thread. The promises chained
+ * after it belong to the thread the dispatcher runs tasks in.
+ * @tparam T The type of the promised value; defaults to `void` if unspecified.
+ */
+template<class T = void>
+class atomic_promise : public std::enable_shared_from_this<atomic_promise<T>> {
+public:
+    /**
+     * @brief Indicates whether this is a `void` promise type or not.
+     */
+    static constexpr inline bool is_void = std::is_void_v<T>;
+
+    /**
+     * @brief The promised object type.
+     */
+    using type = T;
+
+    /**
+     * @brief Defines a type suitable to hold this promise's value, no matter
+     * its type.
+     * @see `juro::promise<T>::value_type`
+     */
+    using value_type = storage_type<T>;
+
+    /**
+     * @brief Represents the possible values a promise can hold.
+     * @see `juro::promise<T>::settle_type`
+     */
+    using settle_type =
+        std::variant<empty_type, value_type, std::exception_ptr>;
+
+private:
+    /**
+     * @brief Bits of the handshake flag set
+     */
+    enum flag : std::uint8_t {
+        /**
+         * @brief Some thread has claimed the right to settle the promise
+         */
+        SETTLING = 1 << 0,
+
+        /**
+         * @brief The promise value has been stored and the promise is resolved
+         */
+        RESOLVED = 1 << 1,
+
+        /**
+         * @brief The promise value has been stored and the promise is rejected
+         */
+        REJECTED = 1 << 2,
+
+        /**
+         * @brief A settle handler has been attached to the internal promise
+         */
+        ATTACHED = 1 << 3
+    };
+
+    /**
+     * @brief The handshake flag set; see `flag`
+     */
+    std::atomic<std::uint8_t> flags = 0;
+
+    /**
+     * @brief Holds the settled value until it is handed to the internal
+     * promise
+     */
+    settle_type value;
+
+    /**
+     * @brief The internal promise, to which settle handlers get attached; it
+     * is only ever settled by the side that completes the handshake
+     */
+    const promise_ptr<T> target;
+
+    /**
+     * @brief The dispatcher through which the internal promise is settled
+     */
+    const dispatcher dispatch;
+
+public:
+    /**
+     * @brief Constructs a pending atomic promise.
+     * @warning This should not be called directly; use `juro::make_atomic()`
+     * instead.
+     * @param dispatch The dispatcher through which settle handlers are to be
+     * executed
+     * @throws promise_error if the dispatcher is empty
+     */
+    explicit atomic_promise(dispatcher dispatch) :
+        target { make_pending<T>() },
+        dispatch { std::move(dispatch) }
+    {
+        if(!this->dispatch) {
+            throw promise_error { "Atomic promises require a dispatcher" };
+        }
+    }
+
+    atomic_promise(atomic_promise &&) = delete;
+    atomic_promise(const atomic_promise &) = delete;
+    ~atomic_promise() noexcept = default;
+
+    atomic_promise &operator=(atomic_promise &&) = delete;
+    atomic_promise &operator=(const atomic_promise &) = delete;
+
+    /**
+     * @brief Returns the current state of the promise.
+     * @return The current state of the promise.
+     */
+    promise_state get_state() const noexcept {
+        const auto current = flags.load(std::memory_order_acquire);
+        if(current & RESOLVED) return promise_state::RESOLVED;
+        if(current & REJECTED) return promise_state::REJECTED;
+        return promise_state::PENDING;
+    }
+
+    /**
+     * @brief Returns whether the promise is pending.
+     * @return Whether the promise is pending.
+     */
+    inline bool is_pending() const noexcept {
+        return get_state() == promise_state::PENDING;
+    }
+
+    /**
+     * @brief Return whether the promise is resolved.
+     * @return Whether the promise is resolved.
+     */
+    inline bool is_resolved() const noexcept {
+        return get_state() == promise_state::RESOLVED;
+    }
+
+    /**
+     * @brief Return whether the promise is rejected.
+     * @return Whether the promise is rejected.
+     */
+    inline bool is_rejected() const noexcept {
+        return get_state() == promise_state::REJECTED;
+    }
+
+    /**
+     * @brief Return whether the promise is either resolved or rejected.
+     * @return Whether the promise is either resolved or rejected.
+     */
+    inline bool is_settled() const noexcept {
+        return get_state() != promise_state::PENDING;
+    }
+
+    /**
+     * @brief Resolves the promise with a given value; may be called from any
+     * thread. Fires the settle handler if there is one already attached.
+     * @tparam T_value The value type with which to settle the promise. Must be
+     * convertible to `T`.
+     * @param resolved_value The value with which to settle the promise.
+     */
+    template<class T_value = value_type>
+    void resolve(T_value &&resolved_value = {}) {
+        static_assert(
+            std::is_convertible_v<T_value, value_type>,
+            "Resolved value is not convertible to promise type"
+        );
+
+        claim("Attempted to resolve an already settled promise");
+        store([&] { value = std::forward<T_value>(resolved_value); });
+        publish(RESOLVED);
+    }
+
+    /**
+     * @brief Rejects the promise with a given value; may be called from any
+     * thread. Fires the settle handler if there is one already attached.
+     * @note Unlike regular promises, rejecting an atomic promise with no
+     * attached handler does not throw, as a handler may still be attached in
+     * another thread.
+     * @tparam T_value The value type with which to settle the promise.
+     * @param rejected_value The value with which to settle the promise. If it
+     * is not an `std::exception_ptr`, it will be stored into one.
+     */
+    template<class T_value = promise_error>
+    void reject(T_value &&rejected_value = promise_error { "Promise was rejected" }) {
+        claim("Attempted to reject an already settled promise");
+
+        store([&] {
+            using bare_type = bare_t<T_value>;
+            if constexpr(std::is_same_v<bare_type, std::exception_ptr>) {
+                value = std::forward<T_value>(rejected_value);
+            } else {
+                value = std::make_exception_ptr(std::forward<T_value>(rejected_value));
+            }
+        });
+        publish(REJECTED);
+    }
+
+    /**
+     * @brief Attaches a settle handler to the promise.
+     * @see `juro::promise<T>::then(T_on_resolve &&, T_on_reject &&)`
+     */
+    template<class T_on_resolve, class T_on_reject>
+    auto then(T_on_resolve &&on_resolve, T_on_reject &&on_reject) {
+        return attach([&] {
+            return target->then(
+                std::forward<T_on_resolve>(on_resolve),
+                std::forward<T_on_reject>(on_reject)
+            );
+        });
+    }
+
+    /**
+     * @brief Attaches a resolve handler to the promise.
+     * @see `juro::promise<T>::then(T_on_resolve &&)`
+     */
+    template<class T_on_resolve>
+    inline auto then(T_on_resolve &&on_resolve) {
+        return attach([&] {
+            return target->then(std::forward<T_on_resolve>(on_resolve));
+        });
+    }
+
+    /**
+     * @brief Attaches a reject handler to the promise.
+     * @see `juro::promise<T>::rescue(T_on_reject &&)`
+     */
+    template<class T_on_reject>
+    inline auto rescue(T_on_reject &&on_reject) {
+        return attach([&] {
+            return target->rescue(std::forward<T_on_reject>(on_reject));
+        });
+    }
+
+    /**
+     * @brief Attaches a settle handler to the promise.
+     * @see `juro::promise<T>::finally(T_on_settle &&)`
+     */
+    template<class T_on_settle>
+    inline auto finally(T_on_settle &&on_settle) {
+        return attach([&] {
+            return target->finally(std::forward<T_on_settle>(on_settle));
+        });
+    }
+
+private:
+    /**
+     * @brief Claims the right to settle this promise, so that no two threads
+     * can write its value at once.
+     * @param message The message of the `promise_error` thrown in case the
+     * promise has already been claimed
+     */
+    void claim(const char *message) {
+        if(flags.fetch_or(SETTLING, std::memory_order_acquire) & SETTLING) {
+            throw promise_error { message };
+        }
+    }
+
+    /**
+     * @brief Stores the settled value through the supplied functor; if it
+     * throws, gives up the claim, so the promise can still be settled.
+     * @tparam T_storer The type of the storer functor
+     * @param storer The functor that actually assigns the value
+     */
+    template<class T_storer>
+    void store(T_storer &&storer) {
+        try {
+            storer();
+        } catch(...) {
+            flags.fetch_and(static_cast<std::uint8_t>(~SETTLING), std::memory_order_release);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Publishes the settled state; if a settle handler has already
+     * been attached, settles the internal promise.
+     * @param state Either `RESOLVED` or `REJECTED`
+     */
+    void publish(flag state) {
+        if(flags.fetch_or(state, std::memory_order_acq_rel) & ATTACHED) {
+            settle();
+        }
+    }
+
+    /**
+     * @brief Attaches a settle handler to the internal promise by calling the
+     * supplied functor, then publishes the attachment; if the promise has
+     * already been settled, settles the internal promise.
+     * @tparam T_attacher The type of the attacher functor
+     * @param attacher The functor that actually attaches the settle handler
+     * @return The chained promise returned by the attacher
+     */
+    template<class T_attacher>
+    auto attach(T_attacher &&attacher) {
+        if(flags.load(std::memory_order_relaxed) & ATTACHED) {
+            throw promise_error {
+                "Attempted to attach a second handler to an atomic promise"
+            };
+        }
+
+        auto next = attacher();
+        const auto previous = flags.fetch_or(ATTACHED, std::memory_order_acq_rel);
+        if(previous & (RESOLVED | REJECTED)) {
+            settle();
+        }
+        return next;
+    }
+
+    /**
+     * @brief Settles the internal promise with the stored value through the
+     * dispatcher.
+     */
+    void settle() {
+        dispatch([self = this->shared_from_this()] { self->settle_target(); });
+    }
+
+    /**
+     * @brief Moves the stored value into the internal promise.
+     */
+    void settle_target() {
+        if(std::holds_alternative<value_type>(value)) {
+            target->resolve(std::move(std::get<value_type>(value)));
+        } else {
+            target->reject(std::move(std::get<std::exception_ptr>(value)));
+        }
+    }
+};
+
+/**
+ * @brief A shared pointer to an `atomic_promise<T>`
+ * @tparam T The type of the promised value
+ */
+template<class T>
+using atomic_promise_ptr = std::shared_ptr<atomic_promise<T>>;
+
+namespace factories {
+
+/**
+ * @brief Creates a new pending atomic promise, that can be settled from any
+ * thread.
+ * @tparam T The type of the promise being created
+ * @param dispatch The dispatcher through which the settle handler is
+ * executed; e.g. `fugax::event_loop::marshal()`
+ * @return The newly created promise
+ * @throws promise_error if the dispatcher is empty
+ */
+template<class T = void>
+auto make_atomic(dispatcher dispatch) {
+    return std::make_shared<atomic_promise<T>>(std::move(dispatch));
+}
+
+} /* namespace factories */
+
+} /* namespace juro */
+
+#endif /* JURO_ATOMIC_PROMISE_HPP */
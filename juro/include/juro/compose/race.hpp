@@ -54,8 +54,8 @@ auto race(promise_ptr<T_values> ...promises) {
                     }
                 );
             } else {
-                promise->then(
-                    [=] (auto &value) { 
+                promise->then_move(
+                    [=] (auto &&value) { 
                         if(race_promise->is_pending()) {
                             race_promise->resolve(std::move(value)); 
                         }
@@ -8,6 +8,7 @@
 #ifndef JURO_FACTORIES_HPP
 #define JURO_FACTORIES_HPP
 
+#include <memory>
 #include "juro/helpers.hpp"
 
 namespace juro::factories {
@@ -33,6 +34,28 @@ auto make_promise(T_launcher &&launcher) {
     return p;
 }
 
+/**
+ * @brief Creates a new promise with storage obtained from the supplied 
+ * allocator and supplies it to the provided launcher functor.
+ * @tparam T The type of the promise being created
+ * @tparam T_allocator The type of the allocator
+ * @tparam T_launcher The type of the launched functor
+ * @param allocator The allocator, used through `std::allocate_shared`
+ * @param launcher The launched functor
+ * @return The newly created promise
+ * @see `juro::pool_allocator`
+ */
+template<class T = void, class T_allocator, class T_launcher>
+auto make_promise(std::allocator_arg_t, const T_allocator &allocator, T_launcher &&launcher) {
+    static_assert(
+        std::is_invocable_v<T_launcher, const promise_ptr<T> &>,
+        "Launcher function has an incompatible signature."
+    );
+    const auto p = std::allocate_shared<promise<T>>(allocator);
+    launcher(p);
+    return p;
+}
+
 /**
  * @brief Creates a new pending promise.
  * @tparam T The type of the promis ebeing created
@@ -43,6 +66,19 @@ auto make_pending() {
     return std::make_shared<promise<T>>();
 }
 
+/**
+ * @brief Creates a new pending promise with storage obtained from the 
+ * supplied allocator.
+ * @tparam T The type of the promise being created
+ * @tparam T_allocator The type of the allocator
+ * @param allocator The allocator, used through `std::allocate_shared`
+ * @return The newly created promise
+ */
+template<class T = void, class T_allocator>
+auto make_pending(std::allocator_arg_t, const T_allocator &allocator) {
+    return std::allocate_shared<promise<T>>(allocator);
+}
+
 /**
  * @brief Creates a new non-void resolved promise.
  * @tparam T The type of the promise being created. Unless explicitly supplied,
@@ -69,6 +105,41 @@ inline auto make_resolved() {
     );
 }
 
+/**
+ * @brief Creates a new non-void resolved promise with storage obtained from 
+ * the supplied allocator.
+ * @tparam T The type of the promise being created. Unless explicitly supplied,
+ * will be inferred from the `value` parameter.
+ * @tparam T_allocator The type of the allocator
+ * @param allocator The allocator, used through `std::allocate_shared`
+ * @param value The value with which to resolve the promise
+ * @return The newly created promise
+ */
+template<class T, class T_allocator>
+auto make_resolved(std::allocator_arg_t, const T_allocator &allocator, T &&value) {
+    return std::allocate_shared<promise<bare_t<T>>>(
+        allocator,
+        resolved_promise_tag {  }, 
+        std::forward<T>(value)
+    );
+}
+
+/**
+ * @brief Creates a new void resolved promise with storage obtained from the
+ * supplied allocator.
+ * @tparam T_allocator The type of the allocator
+ * @param allocator The allocator, used through `std::allocate_shared`
+ * @return The newly created promise
+ */
+template<class T_allocator>
+auto make_resolved(std::allocator_arg_t, const T_allocator &allocator) { 
+    return std::allocate_shared<promise<void>>(
+        allocator,
+        resolved_promise_tag {  }, 
+        void_type {  }
+    );
+}
+
 /**
  * @brief Creates a new rejected promise.
  * @note This is the only supported way of creating a rejected promise without
@@ -89,6 +160,31 @@ auto make_rejected(T_value &&value = T_value { "Promise was rejected" }) {
     );
 }
 
+/**
+ * @brief Creates a new rejected promise with storage obtained from the 
+ * supplied allocator.
+ * @tparam T The type of the promise being created. If unsupplied, defaults to 
+ * `void`
+ * @tparam T_allocator The type of the allocator
+ * @tparam T_value The type of the value with which to reject the promise
+ * @param allocator The allocator, used through `std::allocate_shared`
+ * @param value The value with which to reject the promise
+ * @return The newly create promise
+ * @see `juro::make_rejected(T_value &&)`
+ */
+template<class T = void, class T_allocator, class T_value = promise_error>
+auto make_rejected(
+    std::allocator_arg_t, 
+    const T_allocator &allocator, 
+    T_value &&value = T_value { "Promise was rejected" }
+) {
+    return std::allocate_shared<promise<bare_t<T>>>(
+        allocator,
+        rejected_promise_tag {  }, 
+        std::forward<T_value>(value)
+    );
+}
+
 } /* namespace juro::factories */
 
 #endif /* JURO_FACTORIES_HPP */
\ No newline at end of file
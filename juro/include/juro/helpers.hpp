@@ -7,6 +7,7 @@
 #ifndef JURO_HELPERS_HPP
 #define JURO_HELPERS_HPP
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <type_traits>
@@ -26,6 +27,12 @@ namespace juro::helpers {
 template<class T>
 using promise_ptr = std::shared_ptr<promise<T>>;
 
+/**
+ * @brief A functor that receives a task and arranges for it to be executed
+ * somewhere else, e.g. in an event loop running in another thread
+ */
+using dispatcher = std::function<void(std::function<void()>)>;
+
 /**
  * @brief The exception error thrown by invalid promise operations
  */
@@ -38,6 +45,25 @@ struct promise_error : std::runtime_error {
  */
 enum class promise_state { PENDING, RESOLVED, REJECTED };
 
+/**
+ * @brief The possible ways settle handlers get invoked when a promise is
+ * settled from inside another promise's settle handler
+ */
+enum class dispatch_mode {
+    /**
+     * @brief Settle handlers are invoked immediately, recursing once per
+     * chained promise; this is the default
+     */
+    RECURSIVE,
+
+    /**
+     * @brief Settle handlers are queued and invoked in a loop by the
+     * outermost settlement, so the stack depth does not grow with the chain
+     * length
+     */
+    ITERATIVE
+};
+
 /**
  * @brief Tag type to disambiguate the settled promise constructors call. This
  * represents the resolved state.
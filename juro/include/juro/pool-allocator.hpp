@@ -0,0 +1,34 @@
+/**
+ * @file juro/pool-allocator.hpp
+ * @brief Makes the pooled allocator of utils available to be supplied to the
+ * promise factories
+ * @author André Medeiros
+*/
+
+#ifndef JURO_POOL_ALLOCATOR_HPP
+#define JURO_POOL_ALLOCATOR_HPP
+
+#include <utils/pool-allocator.hpp>
+
+namespace juro {
+
+/**
+ * @brief The per-thread, size-class pool backing `juro::pool_allocator`
+ * @see `utils::size_class_pool`
+ */
+using utils::size_class_pool;
+
+/**
+ * @brief An allocator meant to be supplied to the promise factories, e.g.:
+ * `juro::make_pending<int>(std::allocator_arg, juro::pool_allocator<int> {})`
+ * @details Through `std::allocate_shared`, the promise and its shared pointer
+ * control block are allocated in a single pooled block. Supplied to the
+ * chaining functions the same way, e.g. `.then(std::allocator_arg, ...)`, it
+ * also provides the chained promises and the settle handlers they store.
+ * @see `utils::pool_allocator`
+ */
+using utils::pool_allocator;
+
+} /* namespace juro */
+
+#endif /* JURO_POOL_ALLOCATOR_HPP */
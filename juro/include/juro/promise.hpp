@@ -8,8 +8,9 @@
 #ifndef JURO_PROMISE_HPP
 #define JURO_PROMISE_HPP
 
-#include<functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <stdexcept>
 #include <variant>
 #include "juro/helpers.hpp"
@@ -22,7 +23,121 @@ using namespace juro::helpers;
 using namespace juro::factories;
 using namespace juro::compose;
 
-class promise_interface {
+/**
+ * @brief Sets how settle handlers are invoked in the calling thread when
+ * promises are settled from inside other settle handlers.
+ * @param mode The dispatch mode to be used by the calling thread
+ * @see `juro::helpers::dispatch_mode`
+ */
+void set_dispatch_mode(dispatch_mode mode) noexcept;
+
+/**
+ * @brief Returns the dispatch mode of the calling thread.
+ * @return The dispatch mode of the calling thread
+ */
+dispatch_mode get_dispatch_mode() noexcept;
+
+/**
+ * @brief A type-erased, move-only settle handler whose target is stored in
+ * memory obtained from an allocator, so that chaining promises with a pooled
+ * allocator does not touch the global heap.
+ */
+class settle_handler {
+    /**
+     * @brief The interface of the stored target
+     */
+    struct callable {
+        virtual void invoke() = 0;
+        virtual void destroy() noexcept = 0;
+
+    protected:
+        ~callable() = default;
+    };
+
+    /**
+     * @brief Stores a target along with the allocator that provided its
+     * storage, so it can give the storage back
+     */
+    template<class T_functor, class T_allocator>
+    struct holder final : callable {
+        using allocator_type = typename std::allocator_traits<T_allocator>
+            ::template rebind_alloc<holder>;
+        using traits = std::allocator_traits<allocator_type>;
+
+        T_functor functor;
+        allocator_type allocator;
+
+        template<class T_target>
+        holder(T_target &&functor, const allocator_type &allocator) :
+            functor(std::forward<T_target>(functor)),
+            allocator(allocator)
+            {  }
+
+        void invoke() override { functor(); }
+
+        void destroy() noexcept override {
+            auto owner = allocator;
+            traits::destroy(owner, this);
+            traits::deallocate(owner, this, 1);
+        }
+    };
+
+    callable *target = nullptr;
+
+public:
+    settle_handler() noexcept = default;
+
+    /**
+     * @brief Stores a target in memory obtained from an allocator
+     * @tparam T_allocator The type of the allocator
+     * @tparam T_functor The type of the target
+     * @param allocator The allocator; it is rebound to the stored type
+     * @param functor The target
+     */
+    template<class T_allocator, class T_functor>
+    settle_handler(std::allocator_arg_t, const T_allocator &allocator, T_functor &&functor) {
+        using holder_type = holder<std::decay_t<T_functor>, T_allocator>;
+        using traits = typename holder_type::traits;
+
+        typename holder_type::allocator_type owner { allocator };
+        auto *storage = traits::allocate(owner, 1);
+        try {
+            traits::construct(owner, storage, std::forward<T_functor>(functor), owner);
+        } catch(...) {
+            traits::deallocate(owner, storage, 1);
+            throw;
+        }
+        target = storage;
+    }
+
+    settle_handler(const settle_handler &) = delete;
+    settle_handler(settle_handler &&other) noexcept :
+        target { std::exchange(other.target, nullptr) }
+        {  }
+
+    settle_handler &operator=(const settle_handler &) = delete;
+    settle_handler &operator=(settle_handler &&other) noexcept {
+        if(this != &other) {
+            reset();
+            target = std::exchange(other.target, nullptr);
+        }
+        return *this;
+    }
+
+    ~settle_handler() { reset(); }
+
+    inline void operator()() { target->invoke(); }
+
+    explicit inline operator bool() const noexcept { return target != nullptr; }
+
+private:
+    void reset() noexcept {
+        if(target) std::exchange(target, nullptr)->destroy();
+    }
+};
+
+class promise_interface : 
+    public std::enable_shared_from_this<promise_interface> {
 private:
     /**
      * @brief Holds the current state of the promise; Once settled, it cannot be
@@ -33,7 +148,7 @@ private:
     /**
      * @brief Type-erased callback to be executed once the promise is settled.
      */
-    std::function<void()> on_settle;
+    settle_handler on_settle;
 
 protected:
     promise_interface() noexcept = default;
@@ -45,10 +160,18 @@ protected:
     promise_interface &operator=(promise_interface &&) noexcept = default;
     virtual ~promise_interface() = default;
 
-    void set_settle_handler(std::function<void()> &&handler) noexcept;
-    void resolved() noexcept;
+    void set_settle_handler(settle_handler &&handler);
+    void resolved();
     void rejected();
 
+private:
+    /**
+     * @brief Invokes the settle handler, either immediately or, when in
+     * iterative dispatch mode and already inside a settle handler, by queueing
+     * this promise to be fired by the outermost settlement.
+     */
+    void fire();
+
 public:
     /**
      * @brief Returns the current state of the promise. A promise is pending
@@ -258,30 +381,69 @@ public:
      * @see `juro::helpers::chained_promise_type`
      */
     template<class T_on_resolve, class T_on_reject>
-    auto then(T_on_resolve &&on_resolve, T_on_reject &&on_reject) {
+    inline auto then(T_on_resolve &&on_resolve, T_on_reject &&on_reject) {
+        return then(
+            std::allocator_arg,
+            std::allocator<void> {  },
+            std::forward<T_on_resolve>(on_resolve),
+            std::forward<T_on_reject>(on_reject)
+        );
+    }
+
+    /**
+     * @brief Attaches a settle handler to the promise like
+     * `.then(T_on_resolve &&, T_on_reject &&)`, obtaining the storage of the
+     * chained promise and of the settle handler from the supplied allocator,
+     * e.g. `juro::pool_allocator`.
+     * @tparam T_allocator The type of the allocator
+     * @tparam T_on_resolve The type of the resolve handler
+     * @tparam T_on_reject The type of the reject handler
+     * @param allocator The allocator
+     * @param on_resolve The functor to be invoked when the promise is resolved.
+     * @param on_reject The functor to be invoked when the promise is rejected.
+     * @return A new promise of a type that depends on the types returned by the
+     * functors provided.
+     */
+    template<class T_allocator, class T_on_resolve, class T_on_reject>
+    auto then(
+        std::allocator_arg_t, 
+        const T_allocator &allocator, 
+        T_on_resolve &&on_resolve, 
+        T_on_reject &&on_reject
+    ) {
         assert_resolve_invocable<T_on_resolve>();
         assert_reject_invocable<T_on_reject>();
         
         using next_value_type = 
             chained_promise_type<T, T_on_resolve, T_on_reject>;
 
-        return make_promise<next_value_type>([&] (auto &next_promise) {
-            set_settle_handler([
+        if constexpr(
+            !resolves_promise_v<T, T_on_resolve> && 
+            !rejects_promise_v<T_on_reject>
+        ) {
+            if(is_settled()) {
+                return settle_immediately<next_value_type>(allocator, on_resolve, on_reject);
+            }
+        }
+
+        return make_promise<next_value_type>(std::allocator_arg, allocator, [&] (auto &next_promise) {
+            set_settle_handler(settle_handler { std::allocator_arg, allocator, [
                this,
+               allocator,
                next_promise,
                on_resolve = std::forward<T_on_resolve>(on_resolve),
                on_reject = std::forward<T_on_reject>(on_reject)
-           ] {
+           ] () mutable {
                 try {
                     if(is_resolved()) {
-                        handle_resolve(on_resolve, next_promise);
+                        handle_resolve(allocator, on_resolve, next_promise);
                     } else if(is_rejected()) {
-                        handle_reject(on_reject, next_promise);
+                        handle_reject(allocator, on_reject, next_promise);
                     }
                 } catch(...) {
                     next_promise->reject(std::current_exception());
                 }
-            });
+            } });
         });
     }
 
@@ -298,12 +460,114 @@ public:
      */
     template<class T_on_resolve>
     inline auto then(T_on_resolve &&on_resolve) {
+        return then(std::allocator_arg, std::allocator<void> {  }, std::forward<T_on_resolve>(on_resolve));
+    }
+
+    /**
+     * @brief Attaches a resolve handler to the promise like
+     * `.then(T_on_resolve &&)`, obtaining storage from the supplied allocator.
+     * @see `juro::promise<T>::then(std::allocator_arg_t, const T_allocator &, T_on_resolve &&, T_on_reject &&)`
+     */
+    template<class T_allocator, class T_on_resolve>
+    inline auto then(std::allocator_arg_t, const T_allocator &allocator, T_on_resolve &&on_resolve) {
         return then(
+            std::allocator_arg,
+            allocator,
             std::forward<T_on_resolve>(on_resolve),
             [] (auto &error) -> resolve_result_t<T, T_on_resolve> { std::rethrow_exception(error); }
         );
     }
 
+    /**
+     * @brief Attaches a settle handler to the promise, overwriting any
+     * previously attached one. Unlike `.then()`, the resolve handler receives
+     * the resolved value as an rvalue reference, so it can be moved along the
+     * chain instead of copied.
+     * @warning Once the resolve handler is invoked, the value held by this
+     * promise is left in a moved-from state.
+     * @tparam T_on_resolve The type of the resolve handler; should receive the
+     * promised type as parameter, by rvalue reference or by value.
+     * @tparam T_on_reject The type of the reject handler; should receive an
+     * `std::exception_ptr` as parameter, preferably as a reference.
+     * @param on_resolve The functor to be invoked when the promise is resolved.
+     * @param on_reject The functor to be invoked when the promise is rejected.
+     * @return A new promise of a type that depends on the types returned by the
+     * functors provided.
+     * @see `juro::promise<T>::then(T_on_resolve &&, T_on_reject &&)`
+     */
+    template<class T_on_resolve, class T_on_reject>
+    inline auto then_move(T_on_resolve &&on_resolve, T_on_reject &&on_reject) {
+        return then(
+            move_adapter(std::forward<T_on_resolve>(on_resolve)),
+            std::forward<T_on_reject>(on_reject)
+        );
+    }
+
+    /**
+     * @brief Attaches a settle handler like
+     * `.then_move(T_on_resolve &&, T_on_reject &&)`, obtaining storage from
+     * the supplied allocator.
+     * @see `juro::promise<T>::then(std::allocator_arg_t, const T_allocator &, T_on_resolve &&, T_on_reject &&)`
+     */
+    template<class T_allocator, class T_on_resolve, class T_on_reject>
+    inline auto then_move(
+        std::allocator_arg_t, 
+        const T_allocator &allocator, 
+        T_on_resolve &&on_resolve, 
+        T_on_reject &&on_reject
+    ) {
+        return then(
+            std::allocator_arg,
+            allocator,
+            move_adapter(std::forward<T_on_resolve>(on_resolve)),
+            std::forward<T_on_reject>(on_reject)
+        );
+    }
+
+    /**
+     * @brief Attaches a resolve handler that receives the resolved value as an
+     * rvalue reference, overwriting any previously attached one. In case of 
+     * rejection, the error will be propagated down the promise chain.
+     * @warning Once the resolve handler is invoked, the value held by this
+     * promise is left in a moved-from state.
+     * @tparam T_on_resolve The type of the resolve handler; should receive the
+     * promised type as parameter, by rvalue reference or by value.
+     * @param on_resolve The functor to be invoked when the promise is resolved.
+     * @return A new promise of a type that depends on the type returned by the
+     * functor provided.
+     * @see `juro::promise<T>::then(T_on_resolve &&)`
+     */
+    template<class T_on_resolve>
+    inline auto then_move(T_on_resolve &&on_resolve) {
+        return then(move_adapter(std::forward<T_on_resolve>(on_resolve)));
+    }
+
+    /**
+     * @brief Attaches a resolve handler like `.then_move(T_on_resolve &&)`,
+     * obtaining storage from the supplied allocator.
+     * @see `juro::promise<T>::then(std::allocator_arg_t, const T_allocator &, T_on_resolve &&)`
+     */
+    template<class T_allocator, class T_on_resolve>
+    inline auto then_move(std::allocator_arg_t, const T_allocator &allocator, T_on_resolve &&on_resolve) {
+        return then(std::allocator_arg, allocator, move_adapter(std::forward<T_on_resolve>(on_resolve)));
+    }
+
+    /**
+     * @brief Moves the resolved value into a shared, immutable object, so that
+     * any number of consumers can access it by copying a pointer instead of 
+     * the value itself. Rejections are propagated down the promise chain.
+     * @warning Once the promise is resolved, the value held by this promise is
+     * left in a moved-from state.
+     * @return A new promise of a shared pointer to the resolved value.
+     */
+    inline auto share() {
+        return then_move([] (value_type &&value) {
+            return std::shared_ptr<const value_type> { 
+                std::make_shared<value_type>(std::move(value)) 
+            };
+        });
+    }
+
     /**
      * @brief Attaches a reject handler to the promise, overwriting any
      * previously attached one. If resolved, the value will be passed down
@@ -317,10 +581,22 @@ public:
      */
     template<class T_on_reject>
     inline auto rescue(T_on_reject &&on_reject) {
+        return rescue(std::allocator_arg, std::allocator<void> {  }, std::forward<T_on_reject>(on_reject));
+    }
+
+    /**
+     * @brief Attaches a reject handler like `.rescue(T_on_reject &&)`,
+     * obtaining storage from the supplied allocator.
+     * @see `juro::promise<T>::then(std::allocator_arg_t, const T_allocator &, T_on_resolve &&, T_on_reject &&)`
+     */
+    template<class T_allocator, class T_on_reject>
+    inline auto rescue(std::allocator_arg_t, const T_allocator &allocator, T_on_reject &&on_reject) {
         if constexpr(is_void) {
-            return then([] () noexcept {}, std::forward<T_on_reject>(on_reject));
+            return then(std::allocator_arg, allocator, [] () noexcept {}, std::forward<T_on_reject>(on_reject));
         } else {
             return then(
+                std::allocator_arg,
+                allocator,
                 [] (auto &value) noexcept { return value; },
                 std::forward<T_on_reject>(on_reject)
             );
@@ -340,15 +616,27 @@ public:
      */
     template<class T_on_settle>
     inline auto finally(T_on_settle &&on_settle) {
+        return finally(std::allocator_arg, std::allocator<void> {  }, std::forward<T_on_settle>(on_settle));
+    }
+
+    /**
+     * @brief Attaches a settle handler like `.finally(T_on_settle &&)`,
+     * obtaining storage from the supplied allocator.
+     * @see `juro::promise<T>::then(std::allocator_arg_t, const T_allocator &, T_on_resolve &&, T_on_reject &&)`
+     */
+    template<class T_allocator, class T_on_settle>
+    inline auto finally(std::allocator_arg_t, const T_allocator &allocator, T_on_settle &&on_settle) {
         assert_settle_invocable<T_on_settle>();
 
         if constexpr(is_void) {
             return then(
+                std::allocator_arg,
+                allocator,
                 [=] { return on_settle(std::nullopt); }, 
                 std::forward<T_on_settle>(on_settle)
             );
         } else {
-            return then(on_settle, on_settle);
+            return then(std::allocator_arg, allocator, on_settle, on_settle);
         }
     }
 
@@ -393,16 +681,116 @@ private:
         );
     }
 
+    /**
+     * @brief Wraps a resolve handler that takes the resolved value by rvalue
+     * reference into a functor that can be attached by `.then()`.
+     * @tparam T_on_resolve The type of the resolve handler
+     * @param on_resolve The resolve handler to be wrapped
+     * @return A functor that moves the value into the resolve handler
+     */
+    template<class T_on_resolve>
+    static inline auto move_adapter(T_on_resolve &&on_resolve) {
+        static_assert(!is_void, "Void promises hold no value to be moved.");
+        static_assert(
+            std::is_invocable_v<T_on_resolve, value_type &&>,
+            "Resolve handler has an incompatible signature."
+        );
+
+        return [on_resolve = std::forward<T_on_resolve>(on_resolve)] 
+            (value_type &value) { 
+                return on_resolve(std::move(value)); 
+            };
+    }
+
+    /**
+     * @brief Fast path of `.then()` for already settled promises: invokes the
+     * appropriate handler directly and returns a promise constructed already
+     * settled with its result, without storing any settle handler. As on the
+     * regular path, a rejection that reaches the chained promise is unhandled,
+     * as nothing can be attached to it yet, so it is thrown.
+     * @note Handlers that return promises must be piped, so they are not
+     * eligible for this path.
+     * @tparam T_next_value The type of the chained promise
+     * @tparam T_allocator The type of the allocator of the chained promise
+     * @tparam T_on_resolve The type of the resolve handler
+     * @tparam T_on_reject The type of the reject handler
+     * @param allocator The allocator of the chained promise
+     * @param on_resolve The resolve handler
+     * @param on_reject The reject handler
+     * @return The settled chained promise
+     */
+    template<class T_next_value, class T_allocator, class T_on_resolve, class T_on_reject>
+    promise_ptr<T_next_value> settle_immediately(
+        const T_allocator &allocator,
+        T_on_resolve &on_resolve, 
+        T_on_reject &on_reject
+    ) {
+        using next_storage_type = storage_type<T_next_value>;
+        using next_promise_type = promise<T_next_value>;
+
+        try {
+            if(is_resolved()) {
+                if constexpr(resolves_void_v<T, T_on_resolve>) {
+                    invoke_resolve(on_resolve);
+                    return std::allocate_shared<next_promise_type>(
+                        allocator,
+                        resolved_promise_tag {  }, next_storage_type {  }
+                    );
+                } else {
+                    return std::allocate_shared<next_promise_type>(
+                        allocator,
+                        resolved_promise_tag {  }, 
+                        next_storage_type(invoke_resolve(on_resolve))
+                    );
+                }
+            } else {
+                auto &error = std::get<std::exception_ptr>(value);
+                if constexpr(rejects_void_v<T_on_reject>) {
+                    on_reject(error);
+                    return std::allocate_shared<next_promise_type>(
+                        allocator,
+                        resolved_promise_tag {  }, next_storage_type {  }
+                    );
+                } else {
+                    return std::allocate_shared<next_promise_type>(
+                        allocator,
+                        resolved_promise_tag {  }, 
+                        next_storage_type(on_reject(error))
+                    );
+                }
+            }
+        } catch(...) {
+            throw promise_error { "Unhandled promise rejection" };
+        }
+    }
+
+    /**
+     * @brief Invokes a resolve handler with the resolved value, if any.
+     * @tparam T_on_resolve The type of the resolve handler
+     * @param on_resolve The resolve handler
+     * @return Whatever the resolve handler returns
+     */
+    template<class T_on_resolve>
+    inline decltype(auto) invoke_resolve(T_on_resolve &on_resolve) {
+        if constexpr(is_void) {
+            return on_resolve();
+        } else {
+            return on_resolve(std::get<T>(value));
+        }
+    }
+
     /**
      * @brief Handles promise resolution, calling the resolve handler and 
      * resolving the chained promise.
+     * @tparam T_allocator The type of the allocator used to pipe promises
      * @tparam T_on_resolve The type of the resolve handler
      * @tparam T_next_promise The type of the chained promise
+     * @param allocator The allocator used to pipe promises
      * @param on_resolve The resolve handler to be invoked
      * @param next_promise The chained promise
      */
-    template<class T_on_resolve, class T_next_promise>
-    void handle_resolve(T_on_resolve &on_resolve, T_next_promise &next_promise) {
+    template<class T_allocator, class T_on_resolve, class T_next_promise>
+    void handle_resolve(const T_allocator &allocator, T_on_resolve &on_resolve, T_next_promise &next_promise) {
         if constexpr(is_void) {
             if constexpr(resolves_void_v<T, T_on_resolve>) {
                 on_resolve();
@@ -412,7 +800,7 @@ private:
                 next_promise->resolve(on_resolve());
             }
             if constexpr(resolves_promise_v<T, T_on_resolve>) {
-                on_resolve()->pipe(next_promise);
+                on_resolve()->pipe(next_promise, allocator);
             }
         } else {
             if constexpr(resolves_void_v<T, T_on_resolve>) {
@@ -423,7 +811,7 @@ private:
                 next_promise->resolve(on_resolve(std::get<T>(value)));
             }
             if constexpr(resolves_promise_v<T, T_on_resolve>) {
-                on_resolve(std::get<T>(value))->pipe(next_promise);
+                on_resolve(std::get<T>(value))->pipe(next_promise, allocator);
             }
 
         }
@@ -432,13 +820,15 @@ private:
     /**
      * @brief Handler promise rejection, calling the reject handler and
      * resolving the chained promise.
+     * @tparam T_allocator The type of the allocator used to pipe promises
      * @tparam T_on_reject The type of the reject handler
      * @tparam T_next_promise The type of the chained promise
+     * @param allocator The allocator used to pipe promises
      * @param on_reject The reject handler to be invoked
      * @param next_promise The chained promise
      */
-    template<class T_on_reject, class T_next_promise>
-    void handle_reject(T_on_reject &&on_reject, T_next_promise &next_promise) {
+    template<class T_allocator, class T_on_reject, class T_next_promise>
+    void handle_reject(const T_allocator &allocator, T_on_reject &&on_reject, T_next_promise &next_promise) {
         if constexpr(rejects_void_v<T_on_reject>) {
             on_reject(std::get<std::exception_ptr>(value));
             next_promise->resolve();
@@ -449,7 +839,7 @@ private:
         }
         if constexpr(rejects_promise_v<T_on_reject>) {
             auto &rejected_value = std::get<std::exception_ptr>(value);
-            on_reject(rejected_value)->pipe(next_promise);
+            on_reject(rejected_value)->pipe(next_promise, allocator);
 
         }
     }
@@ -476,18 +866,24 @@ private:
      * @brief Pipes a promise into another: when the current promise is settled,
      * the next will be too with the same state and value.
      * @tparam T_next_promise The target promise type
+     * @tparam T_allocator The type of the allocator of the piping handler
      * @param next_promise the The target promise
+     * @param allocator The allocator of the piping handler
      */
-    template<class T_next_promise>
-    inline void pipe(T_next_promise &&next_promise) {
+    template<class T_next_promise, class T_allocator>
+    inline void pipe(T_next_promise &&next_promise, const T_allocator &allocator) {
         if constexpr(is_void) {
             then(
+                std::allocator_arg,
+                allocator,
                 [=] { next_promise->resolve(); },
                 [=] (auto &error) { next_promise->reject(std::move(error)); }
             );
         } else {
-            then(
-                [=] (auto &value) { next_promise->resolve(std::move(value)); },
+            then_move(
+                std::allocator_arg,
+                allocator,
+                [=] (auto &&value) { next_promise->resolve(std::move(value)); },
                 [=] (auto &error) { next_promise->reject(std::move(error)); }
             );
         }
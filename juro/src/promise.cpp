@@ -1,32 +1,98 @@
+#include <deque>
 #include "juro/promise.hpp"
 
 namespace juro {
 
+namespace {
+
+/**
+ * @brief Per-thread state of the iterative dispatch mode
+ */
+struct trampoline {
+    /**
+     * @brief The dispatch mode in effect in this thread
+     */
+    dispatch_mode mode = dispatch_mode::RECURSIVE;
+
+    /**
+     * @brief Whether settle handlers are being invoked in this thread
+     */
+    bool running = false;
+
+    /**
+     * @brief Promises settled while `running` and whose settle handlers are
+     * yet to be invoked; they are owned by the queue until then
+     */
+    std::deque<std::shared_ptr<promise_interface>> pending;
+};
+
+thread_local trampoline current_trampoline;
+
+} /* anonymous namespace */
+
+void set_dispatch_mode(dispatch_mode mode) noexcept {
+    current_trampoline.mode = mode;
+}
+
+dispatch_mode get_dispatch_mode() noexcept {
+    return current_trampoline.mode;
+}
+
 promise_interface::promise_interface(promise_state state) noexcept :
     state { state }
 {  }
 
-void promise_interface::set_settle_handler(std::function<void()> &&handler) noexcept {
+void promise_interface::set_settle_handler(settle_handler &&handler) {
     on_settle = std::move(handler);
     if(is_settled()) {
         on_settle();
     }
 }
 
-void promise_interface::resolved() noexcept {
+void promise_interface::resolved() {
     state = promise_state::RESOLVED;
     if(on_settle) {
-        on_settle();
+        fire();
     }
 }
 
 void promise_interface::rejected() {
     state = promise_state::REJECTED;
     if(on_settle) {
-        on_settle();
+        fire();
     } else {
         throw promise_error { "Unhandled promise rejection" };
     }
 }
 
+void promise_interface::fire() {
+    auto &trampoline = current_trampoline;
+    auto self = weak_from_this().lock();
+
+    if(trampoline.mode == dispatch_mode::RECURSIVE || !self) {
+        on_settle();
+        return;
+    }
+
+    trampoline.pending.push_back(std::move(self));
+    if(trampoline.running) return;
+
+    trampoline.running = true;
+    std::exception_ptr error;
+    while(!trampoline.pending.empty()) {
+        const auto next = std::move(trampoline.pending.front());
+        trampoline.pending.pop_front();
+        try {
+            next->on_settle();
+        } catch(...) {
+            if(!error) error = std::current_exception();
+        }
+    }
+    trampoline.running = false;
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
 } /* namespace juro */
\ No newline at end of file
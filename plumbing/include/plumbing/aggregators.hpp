@@ -0,0 +1,201 @@
+#ifndef PLUMBING_AGGREGATORS_HPP
+#define PLUMBING_AGGREGATORS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Incremental aggregators for windowed stages: each folds elements in
+ * with `add()` in constant time, combines with another aggregator of the same
+ * kind through `merge()`, and reports its value through `result()`; a
+ * default or configured instance stands for the empty aggregate
+ */
+namespace plumbing::aggregators {
+
+/**
+ * @brief Adds elements up
+ */
+template<class T>
+class sum {
+    T total {  };
+
+public:
+    using result_type = T;
+
+    inline void add(const T &value) { total += value; }
+    inline void merge(const sum &other) { total += other.total; }
+    inline result_type result() const { return total; }
+};
+
+/**
+ * @brief Counts elements
+ */
+template<class T>
+class count {
+    std::size_t total = 0;
+
+public:
+    using result_type = std::size_t;
+
+    inline void add(const T &) noexcept { total++; }
+    inline void merge(const count &other) noexcept { total += other.total; }
+    inline result_type result() const noexcept { return total; }
+};
+
+/**
+ * @brief Keeps the element that comes first in an ordering; empty aggregates
+ * have no result
+ * @tparam T_compare The ordering, e.g. `std::less<T>` for the minimum
+ */
+template<class T, class T_compare>
+class extreme {
+    std::optional<T> value;
+
+public:
+    using result_type = std::optional<T>;
+
+    inline void add(const T &candidate) {
+        if(!value || T_compare {  }(candidate, *value)) value = candidate;
+    }
+
+    inline void merge(const extreme &other) {
+        if(other.value) add(*other.value);
+    }
+
+    inline result_type result() const { return value; }
+};
+
+template<class T>
+using minimum = extreme<T, std::less<T>>;
+
+template<class T>
+using maximum = extreme<T, std::greater<T>>;
+
+/**
+ * @brief A sketch estimating quantiles of finite, non-negative values within a
+ * relative error, in the manner of DDSketch: values are counted in buckets
+ * whose bounds grow geometrically, so adding a value costs one logarithm and
+ * one increment, and the memory depends on the range of the values rather
+ * than on how many there are
+ * @details Each estimate `e` of a value `v` satisfies `|e - v| <= accuracy *
+ * v`; values below `1e-9` are counted as zero. Sketches merge exactly, as
+ * long as they share the same accuracy.
+ */
+template<class T>
+class quantiles {
+    static constexpr double smallest = 1e-9;
+
+    double accuracy;
+    double gamma;
+    double log_gamma;
+    std::vector<std::size_t> buckets;
+    int offset = 0;
+    std::size_t zeros = 0;
+    std::size_t total = 0;
+
+public:
+    using result_type = quantiles;
+
+    /**
+     * @brief Creates an empty sketch
+     * @param accuracy The relative error of the estimates, in `(0, 1)`
+     */
+    explicit quantiles(double accuracy = 0.01) :
+        accuracy(accuracy),
+        gamma((1 + accuracy) / (1 - accuracy)),
+        log_gamma(std::log(gamma))
+    {
+        if(!(accuracy > 0 && accuracy < 1)) {
+            throw std::invalid_argument { "Accuracy must be between 0 and 1" };
+        }
+    }
+
+    /**
+     * @brief How many values the sketch has counted
+     */
+    inline std::size_t count() const noexcept { return total; }
+
+    /**
+     * @throws std::domain_error if the value is negative, infinite or NaN
+     */
+    void add(const T &value) {
+        const auto x = static_cast<double>(value);
+        if(!std::isfinite(x) || x < 0) {
+            throw std::domain_error { "Quantile sketches only hold finite, non-negative values" };
+        }
+
+        total++;
+        if(x < smallest) {
+            zeros++;
+            return;
+        }
+        bucket(static_cast<int>(std::ceil(std::log(x) / log_gamma)))++;
+    }
+
+    /**
+     * @throws std::invalid_argument if the sketches have different accuracies
+     */
+    void merge(const quantiles &other) {
+        if(other.accuracy != accuracy) {
+            throw std::invalid_argument { "Only sketches of the same accuracy can be merged" };
+        }
+
+        for(std::size_t i = 0; i < other.buckets.size(); i++) {
+            if(other.buckets[i] > 0) {
+                bucket(other.offset + static_cast<int>(i)) += other.buckets[i];
+            }
+        }
+        zeros += other.zeros;
+        total += other.total;
+    }
+
+    inline result_type result() const { return *this; }
+
+    /**
+     * @brief Estimates a quantile, e.g. `0.99` for the 99th percentile
+     * @return The estimate, or NaN if the sketch is empty
+     */
+    double quantile(double q) const noexcept {
+        if(total == 0) return std::numeric_limits<double>::quiet_NaN();
+
+        const auto rank = static_cast<std::size_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+        std::size_t seen = zeros;
+        if(seen > rank) return 0;
+
+        for(std::size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if(seen > rank) {
+                return 2 * std::pow(gamma, offset + static_cast<int>(i)) / (gamma + 1);
+            }
+        }
+        return 2 * std::pow(gamma, offset + static_cast<int>(buckets.size()) - 1) / (gamma + 1);
+    }
+
+private:
+    /**
+     * @brief The counter of a bucket, widening the bucket range if needed;
+     * the range only widens when a new extreme value shows up
+     */
+    std::size_t &bucket(int index) {
+        if(buckets.empty()) {
+            offset = index;
+            buckets.push_back(0);
+        } else if(index < offset) {
+            buckets.insert(buckets.begin(), static_cast<std::size_t>(offset - index), 0);
+            offset = index;
+        } else if(index - offset >= static_cast<int>(buckets.size())) {
+            buckets.resize(static_cast<std::size_t>(index - offset) + 1, 0);
+        }
+        return buckets[static_cast<std::size_t>(index - offset)];
+    }
+};
+
+} /* namespace plumbing::aggregators */
+
+#endif /* PLUMBING_AGGREGATORS_HPP */
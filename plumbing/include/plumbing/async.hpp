@@ -0,0 +1,213 @@
+#ifndef PLUMBING_ASYNC_HPP
+#define PLUMBING_ASYNC_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fugax/event-loop.hpp>
+#include <fuss/ring.hpp>
+#include "duplex.hpp"
+
+namespace plumbing {
+
+/**
+ * @brief A stage that moves elements across event loops: it consumes them in
+ * the loop of its upstream, hands them over through a bounded lock-free
+ * queue, and produces them downstream from its target loop, which may run in
+ * another thread, so that the stages after it run concurrently with the
+ * stages before it
+ * @details Elements queued before the target loop gets to them are delivered
+ * downstream as a single chunk. Once `high` elements are queued, the stage
+ * pauses its upstream; it resumes it from the origin loop once the target
+ * loop drains the queue down to `low`. While its downstream is paused, it
+ * stops draining, and chunks are cut down to the room its downstream
+ * reports. Elements taken from the queue and not yet delivered are kept and
+ * delivered first by the next drain, also when delivering a chunk throws; the
+ * elements of that chunk count as handed over. Consuming elements past
+ * `capacity` fails with `std::length_error`.
+ * @note Upstream stages must run in the thread of the origin loop, and
+ * downstream stages in the thread of the target loop; the stage must be
+ * destroyed while neither loop is processing its events.
+ * @tparam T The type of the elements
+ */
+template<class T>
+class async : public duplex<T> {
+    /**
+     * @brief The state shared with the events scheduled in both loops, which
+     * do nothing once the stage is gone
+     */
+    struct channel {
+        async *owner;
+        fugax::event_loop &origin;
+        fugax::event_loop &target;
+        fuss::ring<T> queue;
+        std::atomic<std::size_t> queued = 0;
+        std::atomic<bool> armed = false;
+        std::atomic<bool> throttled = false;
+        std::atomic<bool> held = false;
+
+        channel(async *owner, fugax::event_loop &origin, fugax::event_loop &target, std::size_t capacity) :
+            owner(owner), origin(origin), target(target), queue(capacity) {  }
+    };
+
+    const watermarks limits;
+    const std::shared_ptr<channel> state;
+    std::vector<T> batch;
+    std::size_t sent = 0;
+
+public:
+    using sink<T>::consume;
+
+    /**
+     * @brief Constructs a new asynchronous stage
+     * @param origin The loop run by the thread of the upstream stages
+     * @param target The loop run by the thread of the downstream stages
+     * @param limits The queue watermarks
+     */
+    async(fugax::event_loop &origin, fugax::event_loop &target, watermarks limits = {  }) :
+        limits(limits),
+        state(std::make_shared<channel>(this, origin, target, limits.capacity))
+    {
+        limits.validate();
+    }
+
+    async(const async &) = delete;
+    async(async &&) = delete;
+
+    async &operator=(const async &) = delete;
+    async &operator=(async &&) = delete;
+
+    /**
+     * @brief How many elements are queued and not yet delivered
+     */
+    inline std::size_t queued() const noexcept { return state->queued.load(); }
+
+    std::size_t room() const noexcept final {
+        const auto count = state->queued.load();
+        return count < limits.capacity ? limits.capacity - count : 0;
+    }
+
+    void consume(const T &data) final {
+        if constexpr(std::is_copy_constructible_v<T>) {
+            enqueue(data);
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be queued" };
+        }
+    }
+
+    void consume(T &&data) final {
+        enqueue(std::move(data));
+    }
+
+    void consume_owned(span<T> chunk) final {
+        for(T &datum : chunk) {
+            enqueue(std::move(datum));
+        }
+    }
+
+protected:
+    void downstream_paused() final {
+        state->held.store(true);
+    }
+
+    void downstream_resumed() final {
+        state->held.store(false);
+        arm();
+    }
+
+private:
+    template<class T_data>
+    void enqueue(T_data &&data) {
+        // The queue rounds its capacity up, so the limit is enforced here
+        const auto count = ++state->queued;
+        if(count > limits.capacity || !state->queue.try_emplace(std::forward<T_data>(data))) {
+            --state->queued;
+            throw std::length_error { "Asynchronous stage is full" };
+        }
+
+        if(count >= limits.high && !this->paused()) {
+            state->throttled.store(true);
+            this->pause();
+            if(state->queued.load() <= limits.low && state->throttled.exchange(false)) {
+                this->resume();
+            }
+        }
+        arm();
+    }
+
+    /**
+     * @brief Schedules a drain in the target loop, unless one is pending
+     */
+    void arm() {
+        if(!state->armed.exchange(true)) {
+            state->target.schedule([weak = std::weak_ptr<channel> { state }] {
+                if(auto current = weak.lock()) current->owner->drain();
+            });
+        }
+    }
+
+    /**
+     * @brief Delivers the queued elements downstream, as a single chunk if it
+     * has room for them; runs in the target loop
+     * @details The batch is only refilled from the queue once every element
+     * in it has been sent, so an interrupted drain resumes where it stopped;
+     * each drain refills it at most once.
+     */
+    void drain() {
+        state->armed.store(false);
+
+        // Elements queued after the refill arm another drain
+        bool refilled = false;
+        while(!state->held.load()) {
+            if(sent == batch.size()) {
+                if(refilled) break;
+                refilled = true;
+
+                batch.clear();
+                sent = 0;
+                while(auto element = state->queue.try_pop()) {
+                    batch.push_back(std::move(*element));
+                }
+                if(batch.empty()) break;
+            }
+
+            const auto count = std::min(batch.size() - sent, this->downstream_room());
+            if(count == 0) break;
+
+            const span<T> chunk { batch.data() + sent, count };
+            sent += count;
+            settle(count);
+
+            try {
+                this->produce_owned(chunk);
+            } catch(...) {
+                arm();
+                throw;
+            }
+        }
+    }
+
+    /**
+     * @brief Accounts for elements sent downstream, resuming the upstream
+     * from the origin loop once the stage is drained down to `low`
+     * @param count How many elements were sent
+     */
+    void settle(std::size_t count) {
+        const auto remaining = state->queued -= count;
+
+        if(remaining <= limits.low && state->throttled.exchange(false)) {
+            state->origin.schedule([weak = std::weak_ptr<channel> { state }] {
+                if(auto current = weak.lock()) current->owner->resume();
+            });
+        }
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_ASYNC_HPP */
@@ -0,0 +1,328 @@
+#ifndef PLUMBING_DESCRIPTOR_HPP
+#define PLUMBING_DESCRIPTOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fuss.hpp>
+#include "poller.hpp"
+#include "source.hpp"
+#include "sink.hpp"
+
+namespace plumbing {
+
+namespace messages {
+    namespace descriptor {
+        /**
+         * @brief Shouted when the other end of a descriptor is closed and no
+         * more bytes will be read from it
+         */
+        struct closed : public fuss::message<> {  };
+    }
+}
+
+namespace detail {
+    /**
+     * @brief Puts a descriptor in non-blocking mode
+     * @throws std::system_error if the descriptor flags cannot be changed
+     */
+    inline void make_non_blocking(int fd) {
+        const int flags = ::fcntl(fd, F_GETFL);
+        if(flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            throw std::system_error { errno, std::generic_category(), "Cannot make descriptor non-blocking" };
+        }
+    }
+}
+
+/**
+ * @brief A source that emits the bytes read from a descriptor, such as a
+ * pipe, a socket or an eventfd, whenever it becomes readable
+ * @details Each read scatters into several buffers with a single `readv()`,
+ * and every filled buffer is emitted as a chunk, valid only while it is being
+ * consumed, cut down to the room of the sinks. Reading goes on until the
+ * descriptor would block; once a sink piped from this source pauses, the
+ * source stops emitting, keeps the bytes already read for when it resumes and
+ * stops watching the descriptor, so unread bytes stay in the kernel and, for
+ * sockets, throttle the peer.
+ * @note The descriptor is put in non-blocking mode but is not owned: it must
+ * outlive the source, and so must the poller.
+ */
+class descriptor_source :
+    public source<std::uint8_t>,
+    public fuss::shouter<messages::descriptor::closed> {
+
+    poller &events;
+    const int fd;
+    const std::size_t buffer_size;
+    std::vector<std::vector<std::uint8_t>> buffers;
+    std::vector<iovec> vectors;
+    std::size_t filled = 0;
+    std::size_t emitted = 0;
+    bool is_closed = false;
+
+public:
+    using fuss::shouter<messages::descriptor::closed>::listen;
+    using fuss::shouter<messages::descriptor::closed>::shout;
+
+    /**
+     * @brief Starts reading from a descriptor
+     * @param events The poller reporting the readiness of the descriptor
+     * @param fd The descriptor
+     * @param buffer_size The size of each buffer, i.e. the largest chunk
+     * @param buffer_count How many buffers each read scatters into
+     * @throws std::system_error if the descriptor cannot be watched
+     */
+    descriptor_source(poller &events, int fd, std::size_t buffer_size = 1 << 16, std::size_t buffer_count = 4) :
+        events(events),
+        fd(fd),
+        buffer_size(std::max<std::size_t>(buffer_size, 1)),
+        buffers(std::max<std::size_t>(buffer_count, 1), std::vector<std::uint8_t>(this->buffer_size))
+    {
+        for(auto &buffer : buffers) {
+            vectors.push_back({ buffer.data(), buffer.size() });
+        }
+
+        detail::make_non_blocking(fd);
+        events.watch(fd, readiness::readable, [this] { receive(); });
+    }
+
+    descriptor_source(const descriptor_source &) = delete;
+    descriptor_source(descriptor_source &&) = delete;
+
+    descriptor_source &operator=(const descriptor_source &) = delete;
+    descriptor_source &operator=(descriptor_source &&) = delete;
+
+    ~descriptor_source() override {
+        events.forget(fd, readiness::readable);
+    }
+
+    /**
+     * @brief Whether the other end has been closed
+     */
+    inline bool closed() const noexcept { return is_closed; }
+
+protected:
+    void downstream_paused() final {
+        events.enable(fd, readiness::readable, false);
+    }
+
+    void downstream_resumed() final {
+        if(!emit()) return;
+        events.enable(fd, readiness::readable, !is_closed);
+    }
+
+private:
+    /**
+     * @brief Reads and emits bytes until the descriptor would block or a sink
+     * pauses
+     * @throws std::system_error if reading fails
+     */
+    void receive() {
+        while(!is_closed && emit() && writable()) {
+            const auto count = ::readv(fd, vectors.data(), static_cast<int>(vectors.size()));
+            if(count < 0) {
+                if(errno == EINTR) continue;
+                if(errno == EAGAIN || errno == EWOULDBLOCK) return;
+                throw std::system_error { errno, std::generic_category(), "Cannot read descriptor" };
+            }
+
+            if(count == 0) {
+                is_closed = true;
+                events.forget(fd, readiness::readable);
+                this->template shout<messages::descriptor::closed>();
+                return;
+            }
+
+            filled = static_cast<std::size_t>(count);
+            emitted = 0;
+
+            // A short read means the descriptor has been drained
+            if(filled < buffer_size * buffers.size()) {
+                emit();
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Emits the bytes read and not emitted yet, buffer by buffer,
+     * until a sink pauses or has no room left
+     * @return Whether every byte read has been emitted
+     */
+    bool emit() {
+        while(emitted < filled && writable()) {
+            const auto offset = emitted % buffer_size;
+            const auto length = std::min({ buffer_size - offset, filled - emitted, downstream_room() });
+            if(length == 0) break;
+
+            auto &buffer = buffers[emitted / buffer_size];
+            emitted += length;
+            produce(span<const std::uint8_t> { buffer.data() + offset, length });
+        }
+        return emitted == filled;
+    }
+};
+
+/**
+ * @brief A sink that writes bytes to a descriptor, such as a pipe or a
+ * socket, without blocking
+ * @details Chunks are written at once while nothing is pending; whatever the
+ * descriptor does not take is copied aside and written, gathered with
+ * `writev()`, whenever the descriptor becomes writable. The sink pauses its
+ * upstream once `high` bytes are pending, resumes it once they drain down to
+ * `low`, and refuses chunks that would take the pending bytes past
+ * `capacity` with `std::length_error`. Write errors are thrown as
+ * `std::system_error` from the loop.
+ * @note The descriptor is put in non-blocking mode but is not owned: it must
+ * outlive the sink, and so must the poller. Writing to a closed pipe or
+ * socket raises `SIGPIPE`, which processes using this sink should ignore.
+ */
+class descriptor_sink : public sink<std::uint8_t> {
+    static constexpr std::size_t max_vectors = 64;
+
+    poller &events;
+    const int fd;
+    const watermarks limits;
+    std::deque<std::vector<std::uint8_t>> blocks;
+    std::size_t offset = 0;
+    std::size_t bytes = 0;
+
+public:
+    using sink<std::uint8_t>::consume;
+
+    /**
+     * @brief Starts writing to a descriptor
+     * @param events The poller reporting the readiness of the descriptor
+     * @param fd The descriptor
+     * @param limits The pending byte watermarks
+     * @throws std::system_error if the descriptor cannot be watched
+     */
+    descriptor_sink(poller &events, int fd, watermarks limits = { 1 << 14, 1 << 16, 1 << 20 }) :
+        events(events), fd(fd), limits(limits)
+    {
+        limits.validate();
+
+        detail::make_non_blocking(fd);
+        events.watch(fd, readiness::writable, [this] { flush(); });
+        events.enable(fd, readiness::writable, false);
+    }
+
+    descriptor_sink(const descriptor_sink &) = delete;
+    descriptor_sink(descriptor_sink &&) = delete;
+
+    descriptor_sink &operator=(const descriptor_sink &) = delete;
+    descriptor_sink &operator=(descriptor_sink &&) = delete;
+
+    ~descriptor_sink() override {
+        events.forget(fd, readiness::writable);
+    }
+
+    /**
+     * @brief How many bytes are waiting for the descriptor to become writable
+     */
+    inline std::size_t pending() const noexcept { return bytes; }
+
+    std::size_t room() const noexcept override {
+        return limits.capacity - bytes;
+    }
+
+    void consume(const std::uint8_t &data) override {
+        consume(span<const std::uint8_t> { &data, 1 });
+    }
+
+    void consume(span<const std::uint8_t> chunk) override {
+        if(chunk.empty()) return;
+
+        std::size_t written = 0;
+        if(blocks.empty()) {
+            written = write(chunk);
+            if(written == chunk.size()) return;
+        }
+
+        const auto rest = chunk.size() - written;
+        if(bytes + rest > limits.capacity) {
+            throw std::length_error { "Descriptor sink is full" };
+        }
+
+        if(blocks.empty()) {
+            events.enable(fd, readiness::writable, true);
+        }
+        blocks.emplace_back(chunk.begin() + written, chunk.end());
+        bytes += rest;
+
+        if(bytes >= limits.high) {
+            this->pause();
+        }
+    }
+
+private:
+    /**
+     * @brief Writes as much of a chunk as the descriptor takes
+     * @return How many bytes were written
+     */
+    std::size_t write(span<const std::uint8_t> chunk) {
+        for(;;) {
+            const auto count = ::write(fd, chunk.data(), chunk.size());
+            if(count >= 0) return static_cast<std::size_t>(count);
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            throw std::system_error { errno, std::generic_category(), "Cannot write descriptor" };
+        }
+    }
+
+    /**
+     * @brief Writes pending bytes until the descriptor would block
+     */
+    void flush() {
+        while(!blocks.empty()) {
+            std::array<iovec, max_vectors> vectors;
+            std::size_t used = 0;
+            for(auto &block : blocks) {
+                if(used == vectors.size()) break;
+
+                const auto skip = used == 0 ? offset : 0;
+                vectors[used++] = { block.data() + skip, block.size() - skip };
+            }
+
+            const auto count = ::writev(fd, vectors.data(), static_cast<int>(used));
+            if(count < 0) {
+                if(errno == EINTR) continue;
+                if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+                throw std::system_error { errno, std::generic_category(), "Cannot write descriptor" };
+            }
+
+            auto written = static_cast<std::size_t>(count);
+            bytes -= written;
+            while(written > 0) {
+                const auto left = blocks.front().size() - offset;
+                if(written < left) {
+                    offset += written;
+                    break;
+                }
+                written -= left;
+                offset = 0;
+                blocks.pop_front();
+            }
+        }
+
+        if(blocks.empty()) {
+            events.enable(fd, readiness::writable, false);
+        }
+        if(bytes <= limits.low) {
+            this->resume();
+        }
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_DESCRIPTOR_HPP */
@@ -4,51 +4,175 @@
 #include "source.hpp"
 #include "sink.hpp"
 #include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
 
 namespace plumbing {
     
+/**
+ * @brief A stage that is both a sink and a source; by default, it pauses its
+ * upstream while its downstream is paused, and has as much room as its
+ * downstream
+ */
 template<class T_in, class T_out = T_in>
 struct duplex : public virtual sink<T_in>, public virtual source<T_out> { 
     using type_in = T_in;
     using type_out = T_out;
+
+    std::size_t room() const noexcept override {
+        return this->downstream_room();
+    }
+
+protected:
+    void downstream_paused() override {
+        this->pause();
+    }
+
+    void downstream_resumed() override {
+        this->resume();
+    }
 };
 
+/**
+ * @brief A stage mapping each element to a new one; the function receives
+ * the element as an rvalue and returns the result by value, which is then
+ * handed over downstream
+ * @details Elements consumed by const reference are copied before being
+ * passed to the function; move-only elements must be handed over. Chunks
+ * are transformed as a whole and emitted as a single chunk.
+ */
 template<class T_in, class T_out>
 class transform : public duplex<T_in, T_out> {
     
-    using transform_function = std::function<const T_out &(const T_in &)>;
+    using transform_function = std::function<T_out(T_in &&)>;
     transform_function apply;
+    std::vector<T_out> results;
     
 public:
-    transform(transform_function apply) : apply(apply) {  }
+    using sink<T_in>::consume;
+
+    transform(transform_function apply) : apply(std::move(apply)) {  }
     
     void consume(const T_in &data) final {
-        this->produce(this->apply(data));
+        if constexpr(std::is_copy_constructible_v<T_in>) {
+            this->produce(this->apply(T_in { data }));
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be transformed" };
+        }
+    }
+
+    void consume(T_in &&data) final {
+        this->produce(this->apply(std::move(data)));
+    }
+
+    /**
+     * @brief Transforms a whole chunk into a reused buffer and hands the
+     * results over as a single chunk
+     */
+    void consume(span<const T_in> chunk) final {
+        if constexpr(std::is_copy_constructible_v<T_in>) {
+            results.clear();
+            results.reserve(chunk.size());
+            for(const T_in &datum : chunk) {
+                results.push_back(this->apply(T_in { datum }));
+            }
+            this->produce_owned(span<T_out> { results });
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be transformed" };
+        }
+    }
+
+    void consume_owned(span<T_in> chunk) final {
+        results.clear();
+        results.reserve(chunk.size());
+        for(T_in &datum : chunk) {
+            results.push_back(this->apply(std::move(datum)));
+        }
+        this->produce_owned(span<T_out> { results });
     }
 };
 
+/**
+ * @brief A bounded buffer between two stages; it absorbs bursts while its
+ * downstream is paused, and only pauses its upstream once full past the high
+ * watermark
+ * @details Piped to an active sink, it delivers elements as credit is
+ * requested; piped to any other sink, it delivers them while that sink is
+ * not paused.
+ */
 template<class T>
 class buffer : 
     public duplex<T>,
     public buffered_sink<T> {
+
+    fuss::message_guard demand;
+    bool pulled = false;
     
 protected:
     void pipe_to(sink<T> &target) final {
-        try {
-            auto &active = dynamic_cast<active_sink<T> &>(target);
-            active.listen<messages::active_sink::request_data>(
+        if(auto *active = dynamic_cast<active_sink<T> *>(&target)) {
+            pulled = true;
+            this->hold();
+            demand = active->template listen<messages::active_sink::request_data>(
                 [this](const std::size_t count) {
                    this->next(count); 
                 }
             );
-        } catch(std::bad_cast &error) {  }
+        }
         source<T>::pipe_to(target);
+        if(!pulled && this->writable()) {
+            this->next(buffered_sink<T>::unlimited);
+        }
+    }
+
+    void downstream_paused() final {
+        this->hold();
+    }
+
+    void downstream_resumed() final {
+        if(!pulled) {
+            this->next(buffered_sink<T>::unlimited);
+        }
     }
     
 public:
-    void requested_data(const T &data) {
+    explicit buffer(watermarks limits = {  }) : buffered_sink<T>(limits) {  }
+
+    /**
+     * @brief The free space of the buffer, plus whatever can pass through
+     * on credit to the downstream
+     */
+    std::size_t room() const noexcept final {
+        return this->vacancy(this->downstream_room());
+    }
+
+protected:
+    /**
+     * @brief Cuts deliveries down to the room of the downstream
+     */
+    std::size_t passable() const noexcept final {
+        return this->downstream_room();
+    }
+
+public:
+    void requested_data(const T &data) override {
         this->produce(data);
     }
+
+    void requested_data(T &&data) override {
+        this->produce(std::move(data));
+    }
+
+    void requested_data(span<const T> chunk) override {
+        this->produce(chunk);
+    }
+
+    void requested_data_owned(span<T> chunk) override {
+        this->produce_owned(chunk);
+    }
 };
 
 
@@ -56,8 +180,12 @@ template<class T>
 class splitter : public duplex<std::vector<T>, T> {
     
     void consume(const std::vector<T> &vector) override {
-        for(const T &element : vector) {
-            this->produce(element);
+        this->produce(span<const T> { vector });
+    }
+
+    void consume_owned(span<std::vector<T>> chunk) override {
+        for(auto &vector : chunk) {
+            this->produce_owned(span<T> { vector });
         }
     }
 };
@@ -66,9 +194,10 @@ class splitter : public duplex<std::vector<T>, T> {
 class string_splitter : public duplex<std::string, std::uint8_t> {
     
     void consume(const std::string &vector) override {
-        for(const auto &element : vector) {
-            this->produce(element);
-        }
+        this->produce(span<const std::uint8_t> {
+            reinterpret_cast<const std::uint8_t *>(vector.data()),
+            vector.size()
+        });
     }
 };
 
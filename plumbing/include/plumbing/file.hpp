@@ -0,0 +1,272 @@
+#ifndef PLUMBING_FILE_HPP
+#define PLUMBING_FILE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "source.hpp"
+#include "sink.hpp"
+
+namespace plumbing {
+
+/**
+ * @brief A source that emits the contents of a file as chunks viewing a
+ * read-only memory mapping of it, so bytes reach the first stage without
+ * being copied into user space
+ * @details The kernel is advised that the mapping is read sequentially, and
+ * emitted pages are released as the source advances, so arbitrarily large
+ * files can be replayed with a bounded resident set. Chunks are only valid
+ * while they are being consumed.
+ * @note POSIX only.
+ */
+class mapped_file_source : public source<std::uint8_t> {
+    const std::uint8_t *mapping = nullptr;
+    std::size_t size = 0;
+    std::size_t offset = 0;
+    std::size_t released = 0;
+    const std::size_t chunk_size;
+    bool started = false;
+    bool pumping = false;
+
+public:
+    /**
+     * @brief Maps a file
+     * @param path The file path
+     * @param chunk_size How many bytes each emitted chunk views at most
+     * @throws std::system_error if the file cannot be opened or mapped
+     */
+    explicit mapped_file_source(const std::string &path, std::size_t chunk_size = 1 << 20) :
+        chunk_size(chunk_size == 0 ? 1 : chunk_size)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0) {
+            throw std::system_error { errno, std::generic_category(), "Cannot open " + path };
+        }
+
+        struct stat status;
+        if(::fstat(fd, &status) < 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error { error, std::generic_category(), "Cannot stat " + path };
+        }
+
+        size = static_cast<std::size_t>(status.st_size);
+        if(size > 0) {
+            void *address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(address == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error { error, std::generic_category(), "Cannot map " + path };
+            }
+            ::madvise(address, size, MADV_SEQUENTIAL);
+            mapping = static_cast<const std::uint8_t *>(address);
+        }
+        ::close(fd);
+    }
+
+    mapped_file_source(const mapped_file_source &) = delete;
+    mapped_file_source(mapped_file_source &&) = delete;
+
+    mapped_file_source &operator=(const mapped_file_source &) = delete;
+    mapped_file_source &operator=(mapped_file_source &&) = delete;
+
+    ~mapped_file_source() override {
+        if(mapping) {
+            ::munmap(const_cast<std::uint8_t *>(mapping), size);
+        }
+    }
+
+    /**
+     * @brief How many bytes have not been emitted yet
+     */
+    inline std::size_t remaining() const noexcept { return size - offset; }
+
+    /**
+     * @brief Views the whole mapping
+     */
+    inline span<const std::uint8_t> contents() const noexcept { return { mapping, size }; }
+
+    /**
+     * @brief Emits chunks until the file ends or a sink pauses; chunks are
+     * cut down to the room of the sinks
+     * @details Once pumped, the source carries on by itself whenever its
+     * paused sinks resume, until the file ends; `remaining()` tells how much
+     * is left.
+     * @return Whether the whole file has been emitted
+     */
+    bool pump() {
+        started = true;
+        if(pumping) return offset == size;
+
+        pumping = true;
+        try {
+            while(offset < size && writable()) {
+                const auto length = std::min({ chunk_size, size - offset, downstream_room() });
+                if(length == 0) break;
+
+                produce(span<const std::uint8_t> { mapping + offset, length });
+                offset += length;
+                release();
+            }
+        } catch(...) {
+            pumping = false;
+            throw;
+        }
+        pumping = false;
+        return offset == size;
+    }
+
+protected:
+    void downstream_resumed() final {
+        // Sinks resuming while a chunk is consumed are served by that pump
+        if(started && !pumping) pump();
+    }
+
+private:
+    /**
+     * @brief Drops the whole pages that have been emitted from the mapping
+     */
+    void release() noexcept {
+        static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const auto end = offset / page * page;
+        if(end > released) {
+            ::madvise(const_cast<std::uint8_t *>(mapping) + released, end - released, MADV_DONTNEED);
+            released = end;
+        }
+    }
+};
+
+/**
+ * @brief A sink that writes bytes to a file through a large page-aligned
+ * buffer, so the file is written with few large system calls whatever the
+ * size of the consumed chunks; chunks larger than the buffer are written
+ * directly
+ * @note POSIX only.
+ */
+class file_sink : public sink<std::uint8_t> {
+    struct deallocator {
+        void operator()(std::uint8_t *buffer) const noexcept { std::free(buffer); }
+    };
+
+    static constexpr std::size_t alignment = 4096;
+
+    int fd = -1;
+    const std::size_t capacity;
+    const std::unique_ptr<std::uint8_t[], deallocator> buffer;
+    std::size_t used = 0;
+    std::size_t flushed = 0;
+
+public:
+    using sink<std::uint8_t>::consume;
+
+    /**
+     * @brief Creates or truncates a file
+     * @param path The file path
+     * @param buffer_size The buffer size, rounded up to a multiple of the
+     * page size
+     * @throws std::system_error if the file cannot be opened
+     */
+    explicit file_sink(const std::string &path, std::size_t buffer_size = 1 << 20) :
+        capacity((std::max<std::size_t>(buffer_size, 1) + alignment - 1) / alignment * alignment),
+        buffer(static_cast<std::uint8_t *>(std::aligned_alloc(alignment, capacity)))
+    {
+        if(!buffer) throw std::bad_alloc {  };
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0) {
+            throw std::system_error { errno, std::generic_category(), "Cannot open " + path };
+        }
+    }
+
+    file_sink(const file_sink &) = delete;
+    file_sink(file_sink &&) = delete;
+
+    file_sink &operator=(const file_sink &) = delete;
+    file_sink &operator=(file_sink &&) = delete;
+
+    /**
+     * @brief Flushes the buffer and closes the file; errors cannot be
+     * reported at this point, so call `flush()` first to observe them
+     */
+    ~file_sink() override {
+        try {
+            flush();
+        } catch(...) {  }
+        ::close(fd);
+    }
+
+    void consume(const std::uint8_t &data) override {
+        if(used == capacity) flush();
+        buffer[used++] = data;
+    }
+
+    void consume(span<const std::uint8_t> chunk) override {
+        if(chunk.size() >= capacity) {
+            flush();
+            write(chunk.data(), chunk.size());
+            return;
+        }
+
+        const auto head = std::min(chunk.size(), capacity - used);
+        std::memcpy(buffer.get() + used, chunk.data(), head);
+        used += head;
+        if(head < chunk.size()) {
+            flush();
+            std::memcpy(buffer.get(), chunk.data() + head, chunk.size() - head);
+            used = chunk.size() - head;
+        }
+    }
+
+    /**
+     * @brief Writes the buffered bytes to the file; if writing fails, the
+     * bytes already written are not written again by the next flush
+     * @throws std::system_error if writing fails
+     */
+    void flush() {
+        while(flushed < used) {
+            flushed += write_some(buffer.get() + flushed, used - flushed);
+        }
+        used = 0;
+        flushed = 0;
+    }
+
+private:
+    void write(const std::uint8_t *data, std::size_t length) {
+        while(length > 0) {
+            const auto written = write_some(data, length);
+            data += written;
+            length -= written;
+        }
+    }
+
+    /**
+     * @brief Writes as many bytes as the file takes in a single call,
+     * retrying if interrupted
+     * @return How many bytes were written
+     * @throws std::system_error if writing fails
+     */
+    std::size_t write_some(const std::uint8_t *data, std::size_t length) {
+        while(true) {
+            const auto written = ::write(fd, data, length);
+            if(written >= 0) return static_cast<std::size_t>(written);
+            if(errno != EINTR) {
+                throw std::system_error { errno, std::generic_category(), "Cannot write" };
+            }
+        }
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_FILE_HPP */
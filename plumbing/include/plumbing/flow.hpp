@@ -0,0 +1,74 @@
+#ifndef PLUMBING_FLOW_HPP
+#define PLUMBING_FLOW_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <fuss.hpp>
+
+namespace plumbing {
+
+namespace messages {
+    namespace flow {
+        /**
+         * @brief Shouted when a stage can no longer keep up and upstream
+         * stages should stop producing
+         */
+        struct paused : public fuss::message<> {  };
+
+        /**
+         * @brief Shouted when a paused stage can take more elements again
+         */
+        struct resumed : public fuss::message<> {  };
+    }
+}
+
+/**
+ * @brief The occupancy thresholds of a bounded buffer: it pauses its
+ * upstream once `high` elements are buffered, resumes it once they drain down
+ * to `low`, and refuses elements beyond `capacity`
+ */
+struct watermarks {
+    std::size_t low = 16;
+    std::size_t high = 64;
+    std::size_t capacity = 256;
+
+    /**
+     * @brief Checks that the thresholds are consistent
+     * @throws std::invalid_argument unless `low <= high <= capacity` and the
+     * capacity is not zero
+     */
+    void validate() const {
+        if(low > high || high > capacity || capacity == 0) {
+            throw std::invalid_argument { "Watermarks must satisfy low <= high <= capacity" };
+        }
+    }
+};
+
+/**
+ * @brief The pause/resume side of the backpressure protocol: a stage that is
+ * saturated pauses, and the sources piped to it are notified so that they,
+ * and transitively their own upstream stages, stop producing until it resumes
+ */
+class flow_control : public fuss::shouter<messages::flow::paused, messages::flow::resumed> {
+    bool is_paused = false;
+
+public:
+    inline bool paused() const noexcept { return is_paused; }
+
+protected:
+    void pause() {
+        if(is_paused) return;
+        is_paused = true;
+        this->template shout<messages::flow::paused>();
+    }
+
+    void resume() {
+        if(!is_paused) return;
+        is_paused = false;
+        this->template shout<messages::flow::resumed>();
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_FLOW_HPP */
@@ -0,0 +1,237 @@
+#ifndef PLUMBING_FRAMING_HPP
+#define PLUMBING_FRAMING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "duplex.hpp"
+
+namespace plumbing {
+
+/**
+ * @brief A frame of bytes; frames emitted by framers view the consumed
+ * chunks, or the framer's own reassembly buffer, and are only valid while
+ * they are being consumed
+ */
+using frame = span<const std::uint8_t>;
+
+/**
+ * @brief A stage that cuts a byte stream into frames without copying it:
+ * every frame that lies within a consumed chunk is emitted as a view into
+ * that chunk, and only the bytes of a frame straddling chunk boundaries are
+ * copied, into a buffer where the frame is reassembled
+ * @details The frames found in each chunk are emitted as a single chunk of
+ * frames. Frames longer than `max_frame` bytes, framing included, are refused
+ * with `std::length_error`, so a corrupt stream cannot grow the reassembly
+ * buffer without bounds. The frames completed before the refused one are
+ * still emitted; the bytes held for the refused frame and the rest of its
+ * chunk are dropped, and framing starts over with the next chunk.
+ */
+class framer : public duplex<std::uint8_t, frame> {
+    const std::size_t max_frame;
+    std::vector<std::uint8_t> partial;
+    std::vector<frame> frames;
+
+public:
+    using sink<std::uint8_t>::consume;
+
+    explicit framer(std::size_t max_frame) : max_frame(max_frame) {  }
+
+    /**
+     * @brief How many bytes of an incomplete frame are held for reassembly
+     */
+    inline std::size_t pending() const noexcept { return partial.size(); }
+
+    void consume(const std::uint8_t &data) final {
+        consume(span<const std::uint8_t> { &data, 1 });
+    }
+
+    void consume(span<const std::uint8_t> chunk) final {
+        if(chunk.empty()) return;
+
+        try {
+            cut(chunk);
+        } catch(...) {
+            // Whatever was held belongs to a frame that will never be emitted
+            partial.clear();
+            throw;
+        }
+    }
+
+protected:
+    /**
+     * @brief Finds where the next frame ends
+     * @param held The bytes of the frame held from previous chunks, if any
+     * @param data The bytes that follow
+     * @return How many bytes of `data` complete the frame, or nothing if
+     * the frame does not end within `data`
+     */
+    virtual std::optional<std::size_t> boundary(frame held, frame data) const = 0;
+
+    /**
+     * @brief Strips the framing from a whole frame
+     */
+    virtual frame payload(frame whole) const = 0;
+
+    /**
+     * @throws std::length_error if a frame is longer than `max_frame`
+     */
+    void check(std::uint64_t length) const {
+        if(length > max_frame) {
+            throw std::length_error { "Frame exceeds the maximum frame length" };
+        }
+    }
+
+private:
+    /**
+     * @brief Emits the frames completed by a chunk and holds its incomplete
+     * tail
+     */
+    void cut(span<const std::uint8_t> chunk) {
+        frames.clear();
+        bool reassembled = false;
+        try {
+            if(!partial.empty()) {
+                const auto taken = boundary(partial, chunk);
+                if(!taken) {
+                    hold(chunk);
+                    return;
+                }
+
+                check(partial.size() + *taken);
+                partial.insert(partial.end(), chunk.begin(), chunk.begin() + *taken);
+                chunk = chunk.subspan(*taken);
+                frames.push_back(payload(partial));
+                reassembled = true;
+            }
+
+            while(!chunk.empty()) {
+                const auto taken = boundary({  }, chunk);
+                if(!taken) break;
+
+                check(*taken);
+                frames.push_back(payload(chunk.first_n(*taken)));
+                chunk = chunk.subspan(*taken);
+            }
+        } catch(...) {
+            // The frames found before the refused one are whole; emit them
+            // while the reassembly buffer they may view is still held
+            if(!frames.empty()) this->produce(span<const frame> { frames });
+            throw;
+        }
+
+        this->produce(span<const frame> { frames });
+
+        if(reassembled) partial.clear();
+        hold(chunk);
+    }
+
+    void hold(span<const std::uint8_t> rest) {
+        if(rest.empty()) return;
+
+        partial.insert(partial.end(), rest.begin(), rest.end());
+        if(partial.size() > max_frame) {
+            throw std::length_error { "Frame exceeds the maximum frame length" };
+        }
+    }
+};
+
+/**
+ * @brief A framer for frames ending in a delimiter byte, e.g. `'\n'` for
+ * lines; delimiters are found with `memchr()`, which the C library
+ * vectorises, and are stripped from the emitted frames
+ */
+class delimited_framer : public framer {
+    const std::uint8_t delimiter;
+
+public:
+    explicit delimited_framer(std::uint8_t delimiter = '\n', std::size_t max_frame = 1 << 20) :
+        framer(max_frame), delimiter(delimiter) {  }
+
+protected:
+    std::optional<std::size_t> boundary(frame, frame data) const final {
+        const void *found = std::memchr(data.data(), delimiter, data.size());
+        if(!found) return std::nullopt;
+        return static_cast<std::size_t>(static_cast<const std::uint8_t *>(found) - data.data()) + 1;
+    }
+
+    frame payload(frame whole) const final {
+        return whole.first_n(whole.size() - 1);
+    }
+};
+
+/**
+ * @brief A framer for frames of a fixed length
+ */
+class fixed_framer : public framer {
+    const std::size_t length;
+
+public:
+    explicit fixed_framer(std::size_t length) : framer(length), length(length) {
+        if(length == 0) {
+            throw std::invalid_argument { "Frames must not be empty" };
+        }
+    }
+
+protected:
+    std::optional<std::size_t> boundary(frame held, frame data) const final {
+        const auto missing = length - held.size();
+        if(data.size() < missing) return std::nullopt;
+        return missing;
+    }
+
+    frame payload(frame whole) const final {
+        return whole;
+    }
+};
+
+/**
+ * @brief A framer for frames preceded by their length, as an unsigned
+ * big-endian integer of `header` bytes; headers are stripped from the
+ * emitted frames
+ */
+class length_prefixed_framer : public framer {
+    const std::size_t header;
+
+public:
+    /**
+     * @param header The size of the length prefix, from 1 to 8 bytes
+     * @param max_frame The maximum frame length, prefix included
+     */
+    explicit length_prefixed_framer(std::size_t header = 4, std::size_t max_frame = 1 << 20) :
+        framer(max_frame), header(header)
+    {
+        if(header == 0 || header > 8) {
+            throw std::invalid_argument { "Length prefixes must take from 1 to 8 bytes" };
+        }
+    }
+
+protected:
+    std::optional<std::size_t> boundary(frame held, frame data) const final {
+        if(held.size() + data.size() < header) return std::nullopt;
+
+        std::uint64_t length = 0;
+        for(std::size_t i = 0; i < header; i++) {
+            const auto byte = i < held.size() ? held[i] : data[i - held.size()];
+            length = length << 8 | byte;
+        }
+
+        // Checking the length first keeps the sum from overflowing
+        check(length);
+        check(header + length);
+        const auto missing = header + static_cast<std::size_t>(length) - held.size();
+        if(data.size() < missing) return std::nullopt;
+        return missing;
+    }
+
+    frame payload(frame whole) const final {
+        return whole.subspan(header);
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_FRAMING_HPP */
@@ -0,0 +1,149 @@
+#ifndef PLUMBING_FUSED_HPP
+#define PLUMBING_FUSED_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "duplex.hpp"
+
+namespace plumbing {
+
+/**
+ * @brief A chain of transformations known at compile time; composing two
+ * chains with `>>` concatenates them, and invoking a chain applies each
+ * transformation in turn, so the compiler can inline the whole chain into a
+ * single function
+ * @tparam T_functions The types of the transformations, in order
+ */
+template<class ...T_functions>
+class fused {
+    template<class ...> friend class fused;
+
+    std::tuple<T_functions...> functions;
+
+    template<std::size_t I, class T>
+    constexpr auto apply(T &&value) const {
+        if constexpr(I == sizeof...(T_functions)) {
+            return std::forward<T>(value);
+        } else {
+            return apply<I + 1>(std::get<I>(functions)(std::forward<T>(value)));
+        }
+    }
+
+public:
+    constexpr explicit fused(std::tuple<T_functions...> functions) :
+        functions(std::move(functions)) {  }
+
+    template<class T>
+    constexpr auto operator()(T &&value) const {
+        return apply<0>(std::forward<T>(value));
+    }
+
+    template<class ...T_next>
+    constexpr fused<T_functions..., T_next...> operator>>(fused<T_next...> next) const & {
+        return fused<T_functions..., T_next...> {
+            std::tuple_cat(functions, std::move(next.functions))
+        };
+    }
+
+    template<class ...T_next>
+    constexpr fused<T_functions..., T_next...> operator>>(fused<T_next...> next) && {
+        return fused<T_functions..., T_next...> {
+            std::tuple_cat(std::move(functions), std::move(next.functions))
+        };
+    }
+};
+
+/**
+ * @brief Creates a single-step chain of transformations, to be composed with
+ * others through `>>` and turned into a stage with `fuse()`
+ * @param function A functor mapping each element to a new value
+ */
+template<class T_function>
+constexpr fused<std::decay_t<T_function>> map(T_function &&function) {
+    return fused<std::decay_t<T_function>> {
+        std::tuple<std::decay_t<T_function>> { std::forward<T_function>(function) }
+    };
+}
+
+/**
+ * @brief The result type of a chain of transformations for a given input
+ */
+template<class T_in, class T_fused>
+using fused_result_t = std::decay_t<std::invoke_result_t<const T_fused &, T_in &&>>;
+
+/**
+ * @brief A stream stage running a whole chain of transformations in one
+ * step: each element costs one inlined call and one dispatch, however long
+ * the chain, where a chain of `transform` stages costs a call, a dispatch and
+ * a virtual `consume()` per stage
+ * @tparam T_in The type of the consumed elements
+ * @tparam T_fused The type of the chain of transformations
+ */
+template<class T_in, class T_fused>
+class fused_stage : public duplex<T_in, fused_result_t<T_in, T_fused>> {
+    using T_out = fused_result_t<T_in, T_fused>;
+
+    const T_fused chain;
+    std::vector<T_out> results;
+
+public:
+    using sink<T_in>::consume;
+
+    explicit fused_stage(T_fused chain) : chain(std::move(chain)) {  }
+
+    void consume(const T_in &data) final {
+        if constexpr(std::is_invocable_v<const T_fused &, const T_in &>) {
+            this->produce(chain(data));
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be transformed" };
+        }
+    }
+
+    void consume(T_in &&data) final {
+        this->produce(chain(std::move(data)));
+    }
+
+    /**
+     * @brief Transforms a whole chunk into a reused buffer and hands the
+     * results over as a single chunk
+     */
+    void consume(span<const T_in> chunk) final {
+        if constexpr(std::is_invocable_v<const T_fused &, const T_in &>) {
+            results.clear();
+            results.reserve(chunk.size());
+            for(const T_in &datum : chunk) {
+                results.push_back(chain(datum));
+            }
+            this->produce_owned(span<T_out> { results });
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be transformed" };
+        }
+    }
+
+    void consume_owned(span<T_in> chunk) final {
+        results.clear();
+        results.reserve(chunk.size());
+        for(T_in &datum : chunk) {
+            results.push_back(chain(std::move(datum)));
+        }
+        this->produce_owned(span<T_out> { results });
+    }
+};
+
+/**
+ * @brief Turns a chain of transformations into a stream stage
+ * @tparam T_in The type of the elements the stage consumes
+ * @param chain The chain of transformations, e.g. `map(f) >> map(g)`
+ */
+template<class T_in, class ...T_functions>
+fused_stage<T_in, fused<T_functions...>> fuse(fused<T_functions...> chain) {
+    return fused_stage<T_in, fused<T_functions...>> { std::move(chain) };
+}
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_FUSED_HPP */
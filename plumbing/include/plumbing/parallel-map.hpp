@@ -0,0 +1,305 @@
+#ifndef PLUMBING_PARALLEL_MAP_HPP
+#define PLUMBING_PARALLEL_MAP_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fugax/event-loop.hpp>
+#include "duplex.hpp"
+
+namespace plumbing {
+
+/**
+ * @brief A stage that maps elements on a pool of worker threads and
+ * delivers the results in input order, so CPU-bound transformations scale
+ * past one core without downstream stages noticing
+ * @details Each consumed element gets a sequence number and is queued for
+ * the workers; results are stored in a reorder window indexed by sequence
+ * number and, from the event loop, every result that completes the ordered
+ * prefix is delivered downstream as a single chunk, cut down to the room
+ * the downstream reports. At most `window`
+ * elements may be in flight: the stage pauses its upstream once the window
+ * is full, refuses elements with `std::length_error` past that, and resumes
+ * its upstream once half the window has been delivered. An exception thrown
+ * by the function is rethrown from the loop in place of its result.
+ * @note Upstream and downstream stages must run in the thread of the event
+ * loop; the function is invoked concurrently from the workers.
+ * @tparam T_in The type of the consumed elements
+ * @tparam T_out The type of the results
+ */
+template<class T_in, class T_out = T_in>
+class parallel_map : public duplex<T_in, T_out> {
+public:
+    using map_function = std::function<T_out(T_in &&)>;
+
+private:
+    /**
+     * @brief A position of the reorder window
+     */
+    struct slot {
+        std::optional<T_out> value;
+        std::exception_ptr error;
+        std::atomic<bool> ready = false;
+    };
+
+    /**
+     * @brief An element waiting for a worker
+     */
+    struct job {
+        std::size_t sequence;
+        T_in element;
+    };
+
+    /**
+     * @brief The state shared with the delivery events scheduled in the loop,
+     * which do nothing once the stage is gone
+     */
+    struct channel {
+        parallel_map *owner;
+        std::atomic<bool> armed = false;
+
+        explicit channel(parallel_map *owner) : owner(owner) {  }
+    };
+
+    fugax::event_loop &loop;
+    const map_function function;
+    const std::size_t window;
+    const std::unique_ptr<slot[]> slots;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<job> jobs;
+    bool stopping = false;
+
+    std::size_t next_in = 0;
+    std::size_t next_out = 0;
+    bool held = false;
+    std::vector<T_out> batch;
+
+    const std::shared_ptr<channel> state;
+    std::vector<std::thread> workers;
+
+public:
+    using sink<T_in>::consume;
+
+    /**
+     * @brief Constructs a new parallel map and starts its workers
+     * @param loop The event loop in which results are delivered
+     * @param function The function mapping each element to its result
+     * @param parallelism How many worker threads to run
+     * @param window How many elements may be in flight
+     */
+    parallel_map(
+        fugax::event_loop &loop,
+        map_function function,
+        std::size_t parallelism = std::thread::hardware_concurrency(),
+        std::size_t window = 64
+    ) :
+        loop(loop),
+        function(std::move(function)),
+        window(window),
+        slots(std::make_unique<slot[]>(window)),
+        state(std::make_shared<channel>(this))
+    {
+        if(window == 0) {
+            throw std::invalid_argument { "The window must hold at least one element" };
+        }
+
+        if(parallelism == 0) parallelism = 1;
+        workers.reserve(parallelism);
+        for(std::size_t i = 0; i < parallelism; i++) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    parallel_map(const parallel_map &) = delete;
+    parallel_map(parallel_map &&) = delete;
+
+    parallel_map &operator=(const parallel_map &) = delete;
+    parallel_map &operator=(parallel_map &&) = delete;
+
+    ~parallel_map() {
+        {
+            std::lock_guard lock { mutex };
+            stopping = true;
+        }
+        available.notify_all();
+        for(auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief How many elements have been consumed and not yet delivered
+     */
+    inline std::size_t in_flight() const noexcept { return next_in - next_out; }
+
+    std::size_t room() const noexcept final {
+        return in_flight() < window ? window - in_flight() : 0;
+    }
+
+    void consume(const T_in &data) final {
+        if constexpr(std::is_copy_constructible_v<T_in>) {
+            submit(T_in { data });
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be mapped" };
+        }
+    }
+
+    void consume(T_in &&data) final {
+        submit(std::move(data));
+    }
+
+    void consume_owned(span<T_in> chunk) final {
+        for(T_in &datum : chunk) {
+            submit(std::move(datum));
+        }
+    }
+
+protected:
+    void downstream_paused() final {
+        held = true;
+    }
+
+    void downstream_resumed() final {
+        held = false;
+        arm();
+    }
+
+private:
+    void submit(T_in &&data) {
+        if(in_flight() >= window) {
+            throw std::length_error { "Parallel map window is full" };
+        }
+
+        {
+            std::lock_guard lock { mutex };
+            jobs.push_back({ next_in++, std::move(data) });
+        }
+        available.notify_one();
+
+        if(in_flight() >= window) {
+            this->pause();
+        }
+    }
+
+    /**
+     * @brief The body of each worker thread
+     */
+    void work() {
+        for(;;) {
+            std::optional<job> current;
+            {
+                std::unique_lock lock { mutex };
+                available.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if(stopping) return;
+
+                current.emplace(std::move(jobs.front()));
+                jobs.pop_front();
+            }
+
+            auto &target = slots[current->sequence % window];
+            try {
+                target.value.emplace(function(std::move(current->element)));
+            } catch(...) {
+                target.error = std::current_exception();
+            }
+            target.ready.store(true, std::memory_order_release);
+            arm();
+        }
+    }
+
+    /**
+     * @brief Schedules a delivery in the loop, unless one is pending
+     */
+    void arm() {
+        if(!state->armed.exchange(true)) {
+            loop.schedule([weak = std::weak_ptr<channel> { state }] {
+                if(auto current = weak.lock()) current->owner->deliver();
+            });
+        }
+    }
+
+    /**
+     * @brief Delivers the ready results that follow the last delivered one,
+     * in order, in chunks no larger than the downstream room; runs in the
+     * loop
+     * @details Results are only taken out of the window for the chunk being
+     * delivered, so if delivering it throws, the rest stay in the window.
+     * Results left over for lack of room are delivered by another event.
+     */
+    void deliver() {
+        state->armed.store(false);
+
+        while(!held) {
+            const auto limit = this->downstream_room();
+
+            batch.clear();
+            while(batch.size() < limit && ready()) {
+                auto &current = slots[next_out % window];
+                if(current.error) break;
+
+                batch.push_back(std::move(*current.value));
+                current.value.reset();
+                current.ready.store(false, std::memory_order_relaxed);
+                next_out++;
+            }
+
+            if(!batch.empty()) {
+                try {
+                    this->produce_owned(span<T_out> { batch });
+                } catch(...) {
+                    settle();
+                    arm();
+                    throw;
+                }
+            }
+            settle();
+
+            if(ready() && slots[next_out % window].error) {
+                auto &current = slots[next_out % window];
+                current.ready.store(false, std::memory_order_relaxed);
+                next_out++;
+                arm();
+                std::rethrow_exception(std::exchange(current.error, nullptr));
+            }
+
+            if(batch.size() < limit || !ready()) return;
+            if(batch.empty()) break;
+        }
+
+        if(!held && ready()) arm();
+    }
+
+    /**
+     * @brief Whether the result following the last delivered one is ready
+     */
+    bool ready() const noexcept {
+        return next_out != next_in
+            && slots[next_out % window].ready.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Resumes the upstream once half the window has been delivered
+     */
+    void settle() {
+        if(this->paused() && in_flight() <= window / 2) {
+            this->resume();
+        }
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_PARALLEL_MAP_HPP */
@@ -0,0 +1,186 @@
+#ifndef PLUMBING_POLLER_HPP
+#define PLUMBING_POLLER_HPP
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#include <fugax/event-guard.hpp>
+#include <fugax/event-loop.hpp>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace plumbing {
+
+/**
+ * @brief The readiness conditions a file descriptor can be watched for
+ */
+enum class readiness { readable, writable };
+
+/**
+ * @brief Bridges file descriptor readiness into a fugax event loop: on every
+ * loop run it polls an epoll instance, without blocking, and invokes the
+ * handlers of the descriptors that became ready
+ * @note Linux only. Handlers run in the thread of the loop; hang-ups and
+ * errors are reported to every enabled handler of the descriptor, which
+ * find out about them when reading or writing.
+ */
+class poller {
+    using handler = std::function<void()>;
+
+    /**
+     * @brief The handlers and interest of a watched descriptor
+     */
+    struct watch_entry {
+        std::shared_ptr<handler> on_readable;
+        std::shared_ptr<handler> on_writable;
+        bool readable = false;
+        bool writable = false;
+        bool registered = false;
+    };
+
+    const int epoll;
+    std::unordered_map<int, watch_entry> entries;
+    fugax::event_guard task;
+
+public:
+    /**
+     * @brief Creates a poller and attaches it to a loop
+     * @param loop The loop in which readiness is polled and handlers run
+     * @throws std::system_error if the epoll instance cannot be created
+     */
+    explicit poller(fugax::event_loop &loop) : epoll(::epoll_create1(EPOLL_CLOEXEC)) {
+        if(epoll < 0) {
+            throw std::system_error { errno, std::generic_category(), "Cannot create epoll instance" };
+        }
+        task = loop.always([this] { poll(); });
+    }
+
+    poller(const poller &) = delete;
+    poller(poller &&) = delete;
+
+    poller &operator=(const poller &) = delete;
+    poller &operator=(poller &&) = delete;
+
+    ~poller() {
+        task.release();
+        ::close(epoll);
+    }
+
+    /**
+     * @brief Starts watching a descriptor for a readiness condition; the
+     * condition is enabled at once
+     * @param fd The descriptor
+     * @param condition The readiness condition
+     * @param on_ready The handler invoked whenever the condition holds
+     */
+    void watch(int fd, readiness condition, handler on_ready) {
+        auto &entry = entries[fd];
+        auto target = std::make_shared<handler>(std::move(on_ready));
+        if(condition == readiness::readable) {
+            entry.on_readable = std::move(target);
+        } else {
+            entry.on_writable = std::move(target);
+        }
+        enable(fd, condition, true);
+    }
+
+    /**
+     * @brief Enables or disables a condition of a watched descriptor, e.g.
+     * to stop reading while downstream stages are saturated
+     */
+    void enable(int fd, readiness condition, bool enabled) {
+        auto found = entries.find(fd);
+        if(found == entries.end()) return;
+
+        auto &entry = found->second;
+        (condition == readiness::readable ? entry.readable : entry.writable) = enabled;
+        update(fd, entry);
+    }
+
+    /**
+     * @brief Stops watching a descriptor for a condition; errors are
+     * ignored, as the descriptor may already have been closed
+     */
+    void forget(int fd, readiness condition) noexcept {
+        auto found = entries.find(fd);
+        if(found == entries.end()) return;
+
+        auto &entry = found->second;
+        if(condition == readiness::readable) {
+            entry.on_readable.reset();
+            entry.readable = false;
+        } else {
+            entry.on_writable.reset();
+            entry.writable = false;
+        }
+
+        if(!entry.on_readable && !entry.on_writable) {
+            ::epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+            entries.erase(found);
+        } else {
+            epoll_event event {  };
+            event.events = (entry.readable ? EPOLLIN : 0u) | (entry.writable ? EPOLLOUT : 0u);
+            event.data.fd = fd;
+            ::epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+        }
+    }
+
+    /**
+     * @brief Invokes the handlers of the descriptors that are ready
+     * @param timeout How long to wait for readiness, in milliseconds
+     */
+    void poll(int timeout = 0) {
+        std::array<epoll_event, 64> events;
+        const int count = ::epoll_wait(epoll, events.data(), events.size(), timeout);
+        if(count < 0) {
+            if(errno == EINTR) return;
+            throw std::system_error { errno, std::generic_category(), "Cannot poll" };
+        }
+
+        for(int i = 0; i < count; i++) {
+            const int fd = events[i].data.fd;
+            const auto flags = events[i].events;
+            const bool failed = flags & (EPOLLHUP | EPOLLERR);
+
+            if(flags & EPOLLIN || failed) invoke(fd, readiness::readable);
+            if(flags & EPOLLOUT || failed) invoke(fd, readiness::writable);
+        }
+    }
+
+private:
+    /**
+     * @brief Invokes a handler, if it is still enabled; the handler is kept
+     * alive during the call even if it forgets its descriptor
+     */
+    void invoke(int fd, readiness condition) {
+        auto found = entries.find(fd);
+        if(found == entries.end()) return;
+
+        auto &entry = found->second;
+        const bool enabled = condition == readiness::readable ? entry.readable : entry.writable;
+        auto target = condition == readiness::readable ? entry.on_readable : entry.on_writable;
+        if(enabled && target) {
+            (*target)();
+        }
+    }
+
+    void update(int fd, watch_entry &entry) {
+        epoll_event event {  };
+        event.events = (entry.readable ? EPOLLIN : 0u) | (entry.writable ? EPOLLOUT : 0u);
+        event.data.fd = fd;
+
+        const int operation = entry.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if(::epoll_ctl(epoll, operation, fd, &event) < 0) {
+            throw std::system_error { errno, std::generic_category(), "Cannot watch descriptor" };
+        }
+        entry.registered = true;
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_POLLER_HPP */
@@ -1,7 +1,14 @@
 #ifndef PLUMBING_SINK_HPP
 #define PLUMBING_SINK_HPP
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <fuss.hpp>
+#include "plumbing/flow.hpp"
 #include "plumbing/source.hpp"
 #include <utils/circular-queue.hpp>
 
@@ -14,17 +21,71 @@ namespace active_sink {
 } /* namespace active_sink */
 } /* namespace messages */
 
+/**
+ * @brief A stream stage that consumes elements; it can pause the sources
+ * piped to it through its `flow_control` side
+ */
 template<class T>
-class sink {
+class sink : public flow_control {
+    template<class> friend class source;
+
+    source<T> *upstream = nullptr;
     fuss::message_guard guard;
+    fuss::message_guard owned_guard;
 
 public:
     using type_in = T;
     
-    virtual ~sink() = default;
+    virtual ~sink() {
+        unpipe();
+    }
     virtual void consume([[maybe_unused]] const T &data) {  }
+
+    /**
+     * @brief How many more elements the sink can consume right now without
+     * refusing any; sources emitting large chunks cut them down to this.
+     * Unbounded by default
+     */
+    virtual std::size_t room() const noexcept {
+        return std::numeric_limits<std::size_t>::max();
+    }
+
+    /**
+     * @brief Consumes a chunk of elements; sinks that can handle whole chunks
+     * override this, the default feeds elements one by one to
+     * `consume(const T &)`
+     */
+    virtual void consume(span<const T> chunk) {
+        for(const T &datum : chunk) {
+            consume(datum);
+        }
+    }
+
+    /**
+     * @brief Consumes an element the sink may keep; the default borrows it
+     * through `consume(const T &)`
+     */
+    virtual void consume(T &&data) {
+        consume(static_cast<const T &>(data));
+    }
+
+    /**
+     * @brief Consumes a chunk of elements the sink may move from; the
+     * default borrows them through `consume(span<const T>)`, so sinks that
+     * store or forward elements override this to move them instead
+     */
+    virtual void consume_owned(span<T> chunk) {
+        consume(span<const T> { chunk.data(), chunk.size() });
+    }
     
-    template<class T_collection, class = decltype(std::begin(std::declval<T_collection>()))>
+    template<
+        class T_collection,
+        class = decltype(std::begin(std::declval<T_collection>())),
+        class = std::enable_if_t<
+            !std::is_convertible_v<T_collection, const T &> &&
+            !std::is_convertible_v<T_collection, span<const T>>
+        >
+    >
     void consume(T_collection &&data) {
         for(auto &&datum : data) {
             consume(std::forward<decltype(datum)>(datum));
@@ -39,52 +100,284 @@ public:
     
     void virtual piped([[maybe_unused]] source<T> &source) {  }
 
+    /**
+     * @brief Pipes this sink from a source, unpiping it from the previous one
+     */
     void pipe_from(source<T> &source) {
-        guard = source.template listen<messages::source::data_available<T>>([this] (T data) {
-            consume(std::move(data));
+        unpipe();
+        guard = source.template listen<messages::source::data_available<T>>([this] (span<const T> chunk) {
+            consume(chunk);
+        });
+        owned_guard = source.template listen<messages::source::data_owned<T>>([this] (span<T> chunk) {
+            consume_owned(chunk);
         });
+        upstream = &source;
+        source.track(*this);
         piped(source);
     }
-    
+
+private:
+    /**
+     * @brief Stops consuming from the upstream source, which stops counting
+     * this sink as piped and, if it is paused, as paused
+     */
+    void unpipe() {
+        guard.cancel();
+        owned_guard.cancel();
+        if(upstream) {
+            std::exchange(upstream, nullptr)->untrack(*this);
+        }
+    }
 };
 
+/**
+ * @brief A sink that pulls data: it grants upstream buffers credit for a
+ * number of elements, which they deliver as soon as they have them
+ */
 template<class T>
 class active_sink : 
     public sink<T>, 
     public fuss::shouter<messages::active_sink::request_data> {
     
 public:
+    using sink<T>::listen;
+    using sink<T>::shout;
+    using fuss::shouter<messages::active_sink::request_data>::listen;
+    using fuss::shouter<messages::active_sink::request_data>::shout;
+
     void request_data(std::size_t count) {
-        this->shout<messages::active_sink::request_data>(count);
+        this->template shout<messages::active_sink::request_data>(count);
     }
 };
 
+/**
+ * @brief A sink that holds elements in a bounded buffer until it has credit
+ * to pass them on to `requested_data()`; it pauses its upstream when the
+ * buffer reaches the high watermark and resumes it at the low watermark
+ * @details Chunks pass through whole while there is credit for them, and
+ * buffered elements are delivered in chunks. Elements beyond `capacity` are
+ * refused with `std::length_error`: a chunk is buffered up to the capacity
+ * and the rest of it refused, which a source that honours pauses and cuts
+ * its chunks down to `room()` never gets.
+ */
 template<class T>
 class buffered_sink : public virtual sink<T>{
-    circular_queue<T> queue;
-    std::size_t count;
+    utils::circular_queue<T> queue;
+    std::vector<T> batch;
+    std::size_t count = 0;
+    bool delivering = false;
+    const watermarks limits;
     
 public:
     using sink<T>::consume;
+
+    static constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+    explicit buffered_sink(watermarks limits = {  }) : limits(limits) {
+        limits.validate();
+    }
+
+    inline std::size_t buffered() const noexcept { return queue.get_count(); }
+    inline std::size_t credit() const noexcept { return count; }
+
+    std::size_t room() const noexcept override {
+        return vacancy(passable());
+    }
     
     void consume(const T &data) final {
-        if(this->count > 0 && this->queue.is_empty()) {
-            this->count--;
-            this->requested_data(data);
+        if constexpr(std::is_copy_constructible_v<T>) {
+            accept(data);
+        } else {
+            throw std::logic_error { "Move-only elements must be handed over to be buffered" };
+        }
+    }
+
+    void consume(T &&data) final {
+        accept(std::move(data));
+    }
+
+    void consume(span<const T> chunk) final {
+        if constexpr(std::is_copy_constructible_v<T>) {
+            accept(chunk);
         } else {
-            this->queue.push(data);
+            throw std::logic_error { "Move-only elements must be handed over to be buffered" };
         }
     }
+
+    void consume_owned(span<T> chunk) final {
+        accept(chunk);
+    }
     
 protected:
     virtual void requested_data(const T &data) = 0;
+
+    /**
+     * @brief Receives an element delivered out of the buffer, which may be
+     * moved from; the default passes it on to `requested_data(const T &)`
+     */
+    virtual void requested_data(T &&data) {
+        requested_data(static_cast<const T &>(data));
+    }
+
+    /**
+     * @brief Receives a chunk of elements passed through; the default feeds
+     * them one by one to `requested_data(const T &)`
+     */
+    virtual void requested_data(span<const T> chunk) {
+        for(const T &datum : chunk) {
+            requested_data(datum);
+        }
+    }
+
+    /**
+     * @brief Receives a chunk of elements which may be moved from, either
+     * handed over or delivered out of the buffer; the default feeds them one
+     * by one to `requested_data(T &&)`
+     */
+    virtual void requested_data_owned(span<T> chunk) {
+        for(T &datum : chunk) {
+            requested_data(std::move(datum));
+        }
+    }
     
+    /**
+     * @brief Sets the credit to `count` elements and delivers buffered
+     * elements, in chunks, while there is credit
+     */
     void next(std::size_t count) {
-        for(this->count = count; this->count > 0; this->count--) {
-            if(this->queue.is_empty()) break;
-            
-            const T &data = this->queue.pop();
-            this->requested_data(data);
+        this->count = count;
+        deliver();
+    }
+
+    /**
+     * @brief Grants credit for `count` more elements on top of the current
+     * credit, saturating at `unlimited`, and delivers buffered elements, in
+     * chunks, while there is credit
+     */
+    void grant(std::size_t count) {
+        this->count = this->count > unlimited - count ? unlimited : this->count + count;
+        deliver();
+    }
+
+    /**
+     * @brief Withdraws all credit, so further elements are buffered
+     */
+    void hold() noexcept { this->count = 0; }
+
+    /**
+     * @brief How many elements `requested_data()` can take at once without
+     * refusing any; deliveries and elements passing through on credit are
+     * cut down to it. The default places no limit.
+     */
+    virtual std::size_t passable() const noexcept { return unlimited; }
+
+    /**
+     * @brief How many more elements can be consumed without refusing any,
+     * when at most `passing` of them can go through on credit
+     */
+    std::size_t vacancy(std::size_t passing) const noexcept {
+        const auto queued = std::min(this->queue.get_count(), this->limits.capacity);
+        const auto free = this->limits.capacity - queued;
+        if(!this->queue.is_empty()) return free;
+
+        const auto through = std::min(passing, this->count);
+        return through > unlimited - free ? unlimited : through + free;
+    }
+
+private:
+    /**
+     * @brief Delivers buffered elements, in chunks no larger than
+     * `passable()`, while there is credit
+     * @details Elements are only taken out of the queue for the chunk being
+     * delivered, so if delivering it throws, the rest stay buffered.
+     */
+    void deliver() {
+        // Credit granted while delivering is used up by the delivery in course
+        if(delivering) return;
+
+        delivering = true;
+        try {
+            while(this->count > 0 && !this->queue.is_empty()) {
+                const auto available = std::min(this->queue.get_count(), passable());
+                if(available == 0) break;
+
+                const auto taken = take(available);
+
+                batch.clear();
+                for(std::size_t i = 0; i < taken; i++) {
+                    batch.push_back(this->queue.pop());
+                }
+                this->requested_data_owned(span<T> { batch });
+            }
+        } catch(...) {
+            delivering = false;
+            throw;
+        }
+        delivering = false;
+
+        if(this->queue.get_count() <= this->limits.low) {
+            this->resume();
+        }
+    }
+
+    /**
+     * @brief Spends credit on up to `available` elements
+     * @return How many elements the credit covers
+     */
+    std::size_t take(std::size_t available) noexcept {
+        if(this->count == unlimited) return available;
+
+        const auto taken = std::min(this->count, available);
+        this->count -= taken;
+        return taken;
+    }
+
+    template<class T_data>
+    void accept(T_data &&data) {
+        if(this->count > 0 && this->queue.is_empty() && passable() > 0) {
+            if(this->count != unlimited) this->count--;
+            this->requested_data(std::forward<T_data>(data));
+            return;
+        }
+
+        if(this->queue.get_count() >= this->limits.capacity) {
+            throw std::length_error { "Buffer is full" };
+        }
+        this->queue.push(T { std::forward<T_data>(data) });
+        if(this->queue.get_count() >= this->limits.high) {
+            this->pause();
+        }
+    }
+
+    template<class T_element>
+    void accept(span<T_element> chunk) {
+        if(chunk.empty()) return;
+
+        if(this->count > 0 && this->queue.is_empty()) {
+            const auto taken = take(std::min(chunk.size(), passable()));
+            if constexpr(std::is_const_v<T_element>) {
+                this->requested_data(chunk.first_n(taken));
+            } else {
+                this->requested_data_owned(chunk.first_n(taken));
+            }
+            chunk = chunk.subspan(taken);
+            if(chunk.empty()) return;
+        }
+
+        const auto free = this->limits.capacity - std::min(this->queue.get_count(), this->limits.capacity);
+        const auto taken = std::min(free, chunk.size());
+        for(T_element &datum : chunk.first_n(taken)) {
+            if constexpr(std::is_const_v<T_element>) {
+                this->queue.push(datum);
+            } else {
+                this->queue.push(std::move(datum));
+            }
+        }
+        if(this->queue.get_count() >= this->limits.high) {
+            this->pause();
+        }
+        if(taken < chunk.size()) {
+            throw std::length_error { "Buffer is full" };
         }
     }
 };
@@ -1,55 +1,198 @@
 #ifndef PLUMBING_SOURCE_HPP
 #define PLUMBING_SOURCE_HPP
 
+#include <algorithm>
+#include <limits>
+#include <list>
 #include <vector>
 #include <mutex>
 #include <type_traits>
 #include <utility>
 #include <fuss.hpp>
+#include "plumbing/flow.hpp"
+#include "plumbing/span.hpp"
 
 namespace plumbing {
-    
+
 namespace messages {
     namespace source {
+        /**
+         * @brief Shouted with every chunk of elements a source produces;
+         * single elements travel as one-element chunks
+         */
+        template<class T>
+        struct data_available : public fuss::message<span<const T>> {  };
+
+        /**
+         * @brief Shouted with chunks whose elements are handed over to the
+         * only sink piped from a source, which may move from them
+         */
         template<class T>
-        struct data_available : public fuss::message<T> {  };
+        struct data_owned : public fuss::message<span<T>> {  };
     }
 }
 
 template<class T> class sink;
-    
+
 template<class T>
-class source : private fuss::shouter<messages::source::data_available<T>> {
+class source : private fuss::shouter<
+    messages::source::data_available<T>,
+    messages::source::data_owned<T>
+> {
     template<class> friend class sink;
+
+    /**
+     * @brief A sink piped from this source, and the listeners keeping track
+     * of whether it is paused
+     */
+    struct tracked_sink {
+        sink<T> *target;
+        fuss::listener paused;
+        fuss::listener resumed;
+        bool blocking = false;
+    };
+
+    std::list<tracked_sink> downstream;
+    std::size_t blocked = 0;
+
 public:
     using type_out = T;
-    
-    virtual ~source() = default;
-    
+
+    virtual ~source() {
+        for(auto &tracked : downstream) {
+            tracked.paused.cancel();
+            tracked.resumed.cancel();
+            tracked.target->upstream = nullptr;
+        }
+    }
+
+    /**
+     * @brief Whether no sink piped from this source is paused; producers
+     * should hold back elements while this is false
+     */
+    inline bool writable() const noexcept { return blocked == 0; }
+
+    /**
+     * @brief How many elements every sink piped from this source can take
+     * right now without refusing any; producers of large chunks should cut
+     * them down to this
+     */
+    std::size_t downstream_room() const noexcept {
+        auto room = std::numeric_limits<std::size_t>::max();
+        for(const auto &tracked : downstream) {
+            room = std::min(room, tracked.target->room());
+        }
+        return room;
+    }
+
     virtual void produce(const T &data) {
-        this->template shout<messages::source::data_available<T>>(data);
+        produce(span<const T> { &data, 1 });
+    }
+
+    /**
+     * @brief Emits a chunk of elements with a single dispatch; the elements
+     * need only stay alive until this call returns
+     */
+    virtual void produce(span<const T> chunk) {
+        if(chunk.empty()) return;
+        this->template shout<messages::source::data_available<T>>(chunk);
+    }
+
+    virtual void produce(T &&data) {
+        produce_owned(span<T> { &data, 1 });
     }
-    
-    template<class T_collection, class = decltype(std::begin(std::declval<T_collection>()))>
+
+    /**
+     * @brief Emits a chunk of elements the caller gives up: when a single
+     * sink is piped from this source, it may move from them, so elements
+     * travel down a linear pipeline without being copied; otherwise each
+     * sink gets them as in `produce(span<const T>)`
+     */
+    virtual void produce_owned(span<T> chunk) {
+        if(chunk.empty()) return;
+        if(downstream.size() == 1) {
+            this->template shout<messages::source::data_owned<T>>(chunk);
+        } else {
+            produce(span<const T> { chunk.data(), chunk.size() });
+        }
+    }
+
+    template<
+        class T_collection,
+        class = decltype(std::begin(std::declval<T_collection>())),
+        class = std::enable_if_t<
+            !std::is_convertible_v<T_collection, const T &> &&
+            !std::is_convertible_v<T_collection, span<const T>>
+        >
+    >
     void produce(T_collection &&data) {
         for(auto &&datum : data) {
             produce(std::forward<decltype(datum)>(datum));
         }
     }
-    
+
     virtual void pipe_to(sink<T> &sink) {
         sink.pipe_from(*this);
     }
-    
-    
+
+
     template<class T_sink>
     T_sink &operator>>(T_sink &sink) {
-        sink.pipe_from(*this);
+        pipe_to(sink);
         return sink;
     }
+
+protected:
+    /**
+     * @brief Invoked when the first of the sinks piped from this source
+     * pauses
+     */
+    virtual void downstream_paused() {  }
+
+    /**
+     * @brief Invoked when the last paused sink piped from this source resumes
+     */
+    virtual void downstream_resumed() {  }
+
+private:
+    void track(sink<T> &target) {
+        auto &tracked = downstream.emplace_back(tracked_sink { &target, {  }, {  } });
+        tracked.paused = target.template listen<messages::flow::paused>([this, &tracked] {
+            if(tracked.blocking) return;
+            tracked.blocking = true;
+            if(blocked++ == 0) downstream_paused();
+        });
+        tracked.resumed = target.template listen<messages::flow::resumed>([this, &tracked] {
+            if(!tracked.blocking) return;
+            tracked.blocking = false;
+            if(--blocked == 0) downstream_resumed();
+        });
+        if(target.paused()) {
+            tracked.blocking = true;
+            if(blocked++ == 0) downstream_paused();
+        }
+    }
+
+    /**
+     * @brief Forgets a sink that is going away or being piped elsewhere; if
+     * it was the last paused sink, the downstream counts as resumed
+     */
+    void untrack(sink<T> &target) {
+        const auto found = std::find_if(downstream.begin(), downstream.end(), [&target] (const tracked_sink &tracked) {
+            return tracked.target == &target;
+        });
+        if(found == downstream.end()) return;
+
+        found->paused.cancel();
+        found->resumed.cancel();
+        const bool blocking = found->blocking;
+        downstream.erase(found);
+
+        if(blocking && --blocked == 0) downstream_resumed();
+    }
 };
 
-    
+
 } /* namespace plumbing */
 
 #endif /* PLUMBING_SOURCE_HPP */
\ No newline at end of file
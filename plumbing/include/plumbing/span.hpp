@@ -0,0 +1,70 @@
+#ifndef PLUMBING_SPAN_HPP
+#define PLUMBING_SPAN_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace plumbing {
+
+/**
+ * @brief A non-owning view of a contiguous sequence of elements, the unit in
+ * which streams move data
+ * @tparam T The element type; `const`-qualified for read-only views
+ */
+template<class T>
+class span {
+    T *first = nullptr;
+    std::size_t count = 0;
+
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T *;
+
+    constexpr span() noexcept = default;
+    constexpr span(T *data, std::size_t size) noexcept : first(data), count(size) {  }
+
+    /**
+     * @brief Views a contiguous container, or another span, whose elements
+     * are convertible to `T` through a pointer conversion
+     */
+    template<
+        class T_container,
+        class T_pointer = decltype(std::data(std::declval<T_container &>())),
+        class = std::enable_if_t<
+            std::is_convertible_v<T_pointer, T *> &&
+            !std::is_same_v<std::decay_t<T_container>, span>
+        >
+    >
+    constexpr span(T_container &&container) noexcept :
+        first(std::data(container)), count(std::size(container)) {  }
+
+    constexpr T *data() const noexcept { return first; }
+    constexpr std::size_t size() const noexcept { return count; }
+    constexpr bool empty() const noexcept { return count == 0; }
+
+    constexpr iterator begin() const noexcept { return first; }
+    constexpr iterator end() const noexcept { return first + count; }
+
+    constexpr T &operator[](std::size_t i) const noexcept { return first[i]; }
+    constexpr T &front() const noexcept { return first[0]; }
+    constexpr T &back() const noexcept { return first[count - 1]; }
+
+    constexpr span first_n(std::size_t n) const noexcept { return { first, n }; }
+    constexpr span last_n(std::size_t n) const noexcept { return { first + count - n, n }; }
+    constexpr span subspan(std::size_t offset, std::size_t n) const noexcept {
+        return { first + offset, n };
+    }
+    constexpr span subspan(std::size_t offset) const noexcept {
+        return { first + offset, count - offset };
+    }
+};
+
+template<class T_container>
+span(T_container &) -> span<std::remove_pointer_t<decltype(std::data(std::declval<T_container &>()))>>;
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_SPAN_HPP */
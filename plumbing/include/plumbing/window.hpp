@@ -0,0 +1,209 @@
+#ifndef PLUMBING_WINDOW_HPP
+#define PLUMBING_WINDOW_HPP
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fugax/event-guard.hpp>
+#include <fugax/event-loop.hpp>
+#include "aggregators.hpp"
+#include "duplex.hpp"
+
+namespace plumbing {
+
+/**
+ * @brief A stage that folds elements into consecutive, non-overlapping
+ * windows of time and emits the result of each window when it closes, e.g.
+ * a per-second rate with `aggregators::count`
+ * @details Windows are timed by the event loop, the first one opening when
+ * the stage is created; a result is emitted for every window, including
+ * those that received no elements. Elements cost one `add()` each.
+ * @tparam T The type of the consumed elements
+ * @tparam T_aggregator The aggregator, see `plumbing::aggregators`
+ */
+template<class T, class T_aggregator>
+class tumbling_window : public duplex<T, typename T_aggregator::result_type> {
+    const T_aggregator empty;
+    T_aggregator current;
+    fugax::event_guard timer;
+
+public:
+    using sink<T>::consume;
+
+    /**
+     * @brief Constructs a new tumbling window
+     * @param loop The event loop timing the windows
+     * @param width The duration of each window, in loop time units
+     * @param empty The empty aggregate each window starts from
+     */
+    tumbling_window(fugax::event_loop &loop, fugax::time_type width, T_aggregator empty = T_aggregator {  }) :
+        empty(std::move(empty)), current(this->empty)
+    {
+        if(width == 0) {
+            throw std::invalid_argument { "Windows must not be empty" };
+        }
+        timer = loop.schedule(width, true, [this] { close(); });
+    }
+
+    tumbling_window(const tumbling_window &) = delete;
+    tumbling_window(tumbling_window &&) = delete;
+
+    tumbling_window &operator=(const tumbling_window &) = delete;
+    tumbling_window &operator=(tumbling_window &&) = delete;
+
+    void consume(const T &data) final {
+        current.add(data);
+    }
+
+    void consume(span<const T> chunk) final {
+        for(const T &datum : chunk) {
+            current.add(datum);
+        }
+    }
+
+private:
+    void close() {
+        auto result = std::exchange(current, empty).result();
+        this->produce(std::move(result));
+    }
+};
+
+/**
+ * @brief A stage that emits, every `step`, the result of the elements
+ * consumed during the last `width`, e.g. a moving maximum
+ * @details The window is split in `width / step` panes, each aggregated on
+ * its own: elements cost one `add()` in the current pane, and each emission
+ * merges the panes, so no element is ever visited twice. Until `width` has
+ * passed since the stage was created, results cover the time elapsed so far.
+ * @tparam T The type of the consumed elements
+ * @tparam T_aggregator The aggregator, see `plumbing::aggregators`
+ */
+template<class T, class T_aggregator>
+class sliding_window : public duplex<T, typename T_aggregator::result_type> {
+    const T_aggregator empty;
+    std::vector<T_aggregator> panes;
+    std::size_t current = 0;
+    fugax::event_guard timer;
+
+public:
+    using sink<T>::consume;
+
+    /**
+     * @brief Constructs a new sliding window
+     * @param loop The event loop timing the windows
+     * @param width The duration covered by each result, in loop time units
+     * @param step The interval between results; `width` must be a multiple
+     * of it
+     * @param empty The empty aggregate each pane starts from
+     */
+    sliding_window(
+        fugax::event_loop &loop,
+        fugax::time_type width,
+        fugax::time_type step,
+        T_aggregator empty = T_aggregator {  }
+    ) :
+        empty(std::move(empty))
+    {
+        if(step == 0 || width == 0 || width % step != 0) {
+            throw std::invalid_argument { "The window width must be a non-zero multiple of its step" };
+        }
+        panes.assign(width / step, this->empty);
+        timer = loop.schedule(step, true, [this] { close(); });
+    }
+
+    sliding_window(const sliding_window &) = delete;
+    sliding_window(sliding_window &&) = delete;
+
+    sliding_window &operator=(const sliding_window &) = delete;
+    sliding_window &operator=(sliding_window &&) = delete;
+
+    void consume(const T &data) final {
+        panes[current].add(data);
+    }
+
+    void consume(span<const T> chunk) final {
+        auto &pane = panes[current];
+        for(const T &datum : chunk) {
+            pane.add(datum);
+        }
+    }
+
+private:
+    /**
+     * @brief Emits the merged panes and recycles the oldest one
+     */
+    void close() {
+        T_aggregator window = empty;
+        for(const auto &pane : panes) {
+            window.merge(pane);
+        }
+
+        current = (current + 1) % panes.size();
+        panes[current] = empty;
+        this->produce(window.result());
+    }
+};
+
+/**
+ * @brief A stage that groups elements in sessions, bursts of activity
+ * separated by at least `gap` without elements, and emits the result of
+ * each session once its gap has passed
+ * @details Elements cost one `add()` each, and rearming the gap timer costs
+ * a reschedule per consumed element or chunk, without allocations.
+ * @tparam T The type of the consumed elements
+ * @tparam T_aggregator The aggregator, see `plumbing::aggregators`
+ */
+template<class T, class T_aggregator>
+class session_window : public duplex<T, typename T_aggregator::result_type> {
+    const T_aggregator empty;
+    T_aggregator current;
+    std::function<void()> touch;
+
+public:
+    using sink<T>::consume;
+
+    /**
+     * @brief Constructs a new session window
+     * @param loop The event loop timing the sessions
+     * @param gap How long without elements closes a session, in loop time
+     * units
+     * @param empty The empty aggregate each session starts from
+     */
+    session_window(fugax::event_loop &loop, fugax::time_type gap, T_aggregator empty = T_aggregator {  }) :
+        empty(std::move(empty)),
+        current(this->empty),
+        touch(loop.debounce<>(gap, [this] { close(); }))
+    {  }
+
+    session_window(const session_window &) = delete;
+    session_window(session_window &&) = delete;
+
+    session_window &operator=(const session_window &) = delete;
+    session_window &operator=(session_window &&) = delete;
+
+    void consume(const T &data) final {
+        current.add(data);
+        touch();
+    }
+
+    void consume(span<const T> chunk) final {
+        if(chunk.empty()) return;
+
+        for(const T &datum : chunk) {
+            current.add(datum);
+        }
+        touch();
+    }
+
+private:
+    void close() {
+        auto result = std::exchange(current, empty).result();
+        this->produce(std::move(result));
+    }
+};
+
+} /* namespace plumbing */
+
+#endif /* PLUMBING_WINDOW_HPP */
@@ -7,6 +7,7 @@
 **/
 
 
+#include <thread>
 #include <catch2/catch_test_macros.hpp>
 #include <fugax/event-loop.hpp>
 
@@ -809,4 +810,37 @@ SCENARIO("an event loop can throttle calls to a functor", "[fugax]") {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+SCENARIO("an event loop can marshal promise settlement from other threads", "[fugax]") {
+    GIVEN("an event loop and an atomic promise bound to its dispatcher") {
+        fugax::event_loop loop;
+        auto promise = juro::make_atomic<std::string>(loop.marshal());
+
+        AND_GIVEN("a handler attached to the promise") {
+            std::string resolved_string;
+            auto next = promise->then([&] (auto &value) {
+                resolved_string = value;
+            });
+
+            WHEN("the promise is resolved in another thread") {
+                std::thread { [&] { promise->resolve("resolved"s); } }.join();
+
+                THEN("the handler must not have been invoked yet") {
+                    REQUIRE(promise->is_resolved());
+                    REQUIRE(next->is_pending());
+                    REQUIRE(resolved_string.empty());
+                }
+
+                AND_WHEN("the event loop is processed") {
+                    loop.process(0);
+
+                    THEN("the handler must have been invoked in the loop") {
+                        REQUIRE(next->is_resolved());
+                        REQUIRE(resolved_string == "resolved"s);
+                    }
+                }
+            }
+        }
+    }
+}
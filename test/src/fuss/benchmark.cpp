@@ -0,0 +1,63 @@
+/**
+ * @file test/src/fuss/benchmark.cpp
+ * @brief Benchmarks for FUSS; hidden from regular test runs, execute with
+ * `iara-test "[benchmark]"`
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#include <numeric>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <fuss.hpp>
+
+namespace {
+
+struct by_value : public fuss::message<std::vector<int>> {  };
+struct by_reference : public fuss::ref_message<std::vector<int>> {  };
+struct large_shouter : public fuss::shouter<by_value, by_reference> {  };
+
+constexpr int subscriber_count = 8;
+constexpr std::size_t payload_size = 64 * 1024;
+
+} /* anonymous namespace */
+
+TEST_CASE("shouting large payloads", "[.][benchmark][fuss]") {
+    large_shouter shouter;
+    long checksum = 0;
+
+    for(int i = 0; i < subscriber_count; i++) {
+        shouter.listen<by_value>([&] (std::vector<int> payload) {
+            checksum += payload.back();
+        });
+        shouter.listen<by_reference>([&] (const std::vector<int> &payload) {
+            checksum += payload.back();
+        });
+    }
+
+    std::vector<int> payload(payload_size);
+    std::iota(payload.begin(), payload.end(), 0);
+
+    BENCHMARK("by value, lvalue: one copy per subscriber") {
+        shouter.shout<by_value>(payload);
+        return checksum;
+    };
+
+    // The payloads are copied before the timed region, so that only the
+    // copies made for all subscribers but the last one are measured
+    BENCHMARK_ADVANCED("by value, rvalue: moved into the last subscriber")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::vector<int>> payloads(meter.runs(), payload);
+        meter.measure([&] (int run) {
+            shouter.shout<by_value>(std::move(payloads[run]));
+            return checksum;
+        });
+    };
+
+    BENCHMARK("by reference: no copies") {
+        shouter.shout<by_reference>(payload);
+        return checksum;
+    };
+}
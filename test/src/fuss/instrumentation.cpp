@@ -0,0 +1,154 @@
+/**
+ * @file test/src/fuss/instrumentation.cpp
+ * @brief Tests for FUSS dispatch instrumentation; built into a test target
+ * of its own when configured with `-DFUSS_INSTRUMENTATION=ON`
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+#include <fugax/event-loop.hpp>
+#include <fuss.hpp>
+#include <fuss/bus.hpp>
+#include <fuss/coalescing.hpp>
+#include <fuss/deferred.hpp>
+
+#ifndef FUSS_INSTRUMENTATION
+#error "Instrumentation tests require configuring with -DFUSS_INSTRUMENTATION=ON"
+#endif
+
+using namespace std::string_literals;
+
+namespace {
+
+struct instrumented : public fuss::message<int> {  };
+struct instrumented_shouter : public fuss::shouter<instrumented> {  };
+struct bused : public fuss::message<int> {  };
+struct coalesced : public fuss::message<int> {  };
+struct postponed : public fuss::message<int> {  };
+struct postponing_shouter : public fuss::shouter<postponed> {  };
+
+} /* anonymous namespace */
+
+SCENARIO("shouters record dispatch statistics when instrumented", "[fuss]") {
+    GIVEN("an instrumented shouter with a fast and a slow handler") {
+        instrumented_shouter shouter;
+        shouter.listen<instrumented>([] (int) {  });
+        shouter.listen<instrumented>([] (int) {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+        });
+
+        auto &statistics = fuss::instrumentation::catalog::of<instrumented>();
+        statistics.reset();
+
+        WHEN("it shouts twice") {
+            shouter.shout<instrumented>(1);
+            shouter.shout<instrumented>(2);
+
+            THEN("the statistics of its message type must have been updated") {
+                REQUIRE(statistics.shouts == 2);
+                REQUIRE(statistics.handlers == 2);
+                REQUIRE(statistics.invocations == 4);
+                REQUIRE(statistics.total_time >= 2'000'000);
+            }
+
+            THEN("the slowest handler must have been identified") {
+                const auto slowest = statistics.slowest();
+                REQUIRE(slowest.time >= 1'000'000);
+                REQUIRE(slowest.identity.target.slot == 1);
+            }
+
+            THEN("the message type must be listed in the catalog dump") {
+                std::ostringstream stream;
+                fuss::instrumentation::catalog::dump(stream);
+
+                REQUIRE(statistics.name.find("instrumented") != std::string_view::npos);
+                REQUIRE(stream.str().find("shouts=2 handlers=2 invocations=4") != std::string::npos);
+            }
+        }
+    }
+}
+
+SCENARIO("buses and coalescing shouters record dispatch statistics when instrumented", "[fuss]") {
+    GIVEN("an event loop") {
+        fugax::event_loop loop;
+
+        AND_GIVEN("a bus with a handler attached to the loop") {
+            fuss::bus<bused> bus;
+            int received = 0;
+            bus.listen<bused>(loop, [&] (int) { received++; });
+
+            auto &statistics = fuss::instrumentation::catalog::of<bused>();
+            statistics.reset();
+
+            WHEN("messages are shouted and the loop is processed") {
+                bus.shout<bused>(1);
+                bus.shout<bused>(2);
+                loop.process(0);
+
+                THEN("their shouts and deliveries must have been recorded") {
+                    REQUIRE(received == 2);
+                    REQUIRE(statistics.shouts == 2);
+                    REQUIRE(statistics.handlers == 1);
+                    REQUIRE(statistics.invocations == 2);
+                }
+            }
+        }
+
+        AND_GIVEN("a coalescing shouter with a handler") {
+            fuss::coalescing<coalesced> shouter { loop };
+            shouter.listen<coalesced>([] (int) {  });
+
+            auto &statistics = fuss::instrumentation::catalog::of<coalesced>();
+            statistics.reset();
+
+            WHEN("a burst of messages is shouted and the loop is processed") {
+                for(int i = 0; i < 10; i++) shouter.shout<coalesced>(i);
+                loop.process(0);
+
+                THEN("every shout but only the delivery must have been recorded") {
+                    REQUIRE(statistics.shouts == 10);
+                    REQUIRE(statistics.invocations == 1);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("deferred handlers record their runs when instrumented", "[fuss]") {
+    GIVEN("a shouter with a slow deferred handler") {
+        fugax::event_loop loop;
+        postponing_shouter shouter;
+        shouter.listen<postponed>(fuss::deferred(loop, [] (int) {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+        }));
+
+        auto &statistics = fuss::instrumentation::catalog::of<postponed>();
+        statistics.reset();
+
+        WHEN("it shouts") {
+            shouter.shout<postponed>(1);
+
+            THEN("only the scheduling must have been recorded") {
+                REQUIRE(statistics.invocations == 1);
+                REQUIRE(statistics.deferred_invocations == 0);
+            }
+
+            AND_WHEN("the loop is processed") {
+                loop.process(0);
+
+                THEN("the run must have been recorded under the same message") {
+                    REQUIRE(statistics.deferred_invocations == 1);
+                    REQUIRE(statistics.deferred_time >= 1'000'000);
+                    REQUIRE(statistics.slowest().time >= 1'000'000);
+                    REQUIRE(statistics.slowest().identity.target.slot == 0);
+                }
+            }
+        }
+    }
+}
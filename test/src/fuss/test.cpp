@@ -6,13 +6,54 @@
  * @copyright 2023 (C) André Medeiros
 **/
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 #include <fuss.hpp>
+#include <fuss/bus.hpp>
+#include <fuss/coalescing.hpp>
+#include <fuss/deferred.hpp>
+#include <fuss/static-shouter.hpp>
 #include <utils/test-helpers.hpp>
 
 using namespace std::string_literals;
 using namespace utils::test_helpers;
 
+namespace {
+
+struct summed : public fuss::message<int> {  };
+
+/**
+ * @brief A payload that counts how many times it has been copied
+ */
+struct tracked {
+    static inline int copies = 0;
+
+    tracked() = default;
+    tracked(const tracked &) { copies++; }
+    tracked(tracked &&) noexcept = default;
+    tracked &operator=(const tracked &) { copies++; return *this; }
+    tracked &operator=(tracked &&) noexcept = default;
+};
+
+constexpr int static_sum(int value) {
+    int total = 0;
+    auto shouter = fuss::make_static_shouter<summed>(
+        [&] (int value) { total += value; },
+        [&] (int value) { total += 10 * value; }
+    );
+    shouter.shout<summed>(value);
+    return total;
+}
+
+} /* anonymous namespace */
+
 SCENARIO("a shouter can be created for messages of different types", "[fuss]") {
     GIVEN("various messages of various types (msg_1, msg_2, msg_3)") {
         struct msg_1 : public fuss::message<> {  };
@@ -206,6 +247,58 @@ SCENARIO("a message guard can manage the lifetime of a listener", "[fuss]") {
     }
 }
 
+SCENARIO("a message guard can be moved into a container", "[fuss]") {
+    GIVEN("a one-message shouter and a container of message guards") {
+        struct msg : public fuss::message<> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        test_shouter shouter;
+        std::vector<fuss::message_guard> guards;
+        int invocations = 0;
+
+        WHEN("a guard is created in an inner scope and moved into the container") {
+            {
+                fuss::message_guard guard = shouter.listen<msg>([&] {
+                    invocations++;
+                });
+                guards.push_back(std::move(guard));
+            }
+
+            AND_WHEN("the message is shouted") {
+                shouter.shout<msg>();
+
+                THEN("the handler must have been executed once") {
+                    REQUIRE(invocations == 1);
+                }
+            }
+
+            AND_WHEN("the container is cleared and the message is shouted") {
+                guards.clear();
+                shouter.shout<msg>();
+
+                THEN("the handler must not have been executed") {
+                    REQUIRE(invocations == 0);
+                }
+            }
+        }
+
+        WHEN("a guard is move-assigned from another guard") {
+            guards.emplace_back();
+            {
+                fuss::message_guard guard = shouter.listen<msg>([&] {
+                    invocations++;
+                });
+                guards.back() = std::move(guard);
+            }
+            shouter.shout<msg>();
+
+            THEN("the handler must have been executed once") {
+                REQUIRE(invocations == 1);
+            }
+        }
+    }
+}
+
 SCENARIO("shouter groups can aggregate multiple shouter inheritance chains", "[fuss]") {
     GIVEN("a shouter type") {
         struct msg_1 : public fuss::message<> {  };
@@ -298,4 +391,817 @@ SCENARIO("exceptions thrown inside message handlers must propagate") {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+SCENARIO("handlers are stored in a dense registry", "[fuss]") {
+    GIVEN("a registry of handlers") {
+        fuss::registry<std::function<void(int)>> registry;
+        std::vector<int> calls;
+
+        auto first = registry.add([&] (int value) { calls.push_back(value); });
+        auto second = registry.add([&] (int value) { calls.push_back(value * 10); });
+        auto third = registry.add([&] (int value) { calls.push_back(value * 100); });
+
+        THEN("it must be able to tell which handles it contains") {
+            REQUIRE(registry.size() == 3);
+            REQUIRE(registry.contains(first));
+            REQUIRE(registry.contains(second));
+            REQUIRE(registry.contains(third));
+            REQUIRE_FALSE(registry.contains(fuss::handle {  }));
+        }
+
+        WHEN("it is dispatched") {
+            registry.dispatch(1);
+
+            THEN("handlers must have been invoked in insertion order") {
+                REQUIRE(calls == std::vector<int> { 1, 10, 100 });
+            }
+        }
+
+        WHEN("a handler is cancelled") {
+            registry.cancel(second);
+
+            THEN("its handle must no longer be valid") {
+                REQUIRE_FALSE(registry.contains(second));
+                REQUIRE(registry.size() == 2);
+            }
+
+            AND_WHEN("it is dispatched") {
+                registry.dispatch(1);
+
+                THEN("the cancelled handler must not have been invoked") {
+                    REQUIRE(calls == std::vector<int> { 1, 100 });
+                }
+            }
+
+            AND_WHEN("a new handler is added") {
+                auto fourth = registry.add([&] (int value) { calls.push_back(-value); });
+
+                THEN("the stale handle must not refer to the new handler") {
+                    REQUIRE(registry.contains(fourth));
+                    REQUIRE_FALSE(registry.contains(second));
+                }
+
+                AND_WHEN("the stale handle is cancelled") {
+                    registry.cancel(second);
+
+                    THEN("nothing must have been cancelled") {
+                        REQUIRE(registry.size() == 3);
+                        REQUIRE(registry.contains(fourth));
+                    }
+                }
+            }
+        }
+
+        WHEN("most handlers are cancelled, causing a compaction") {
+            registry.cancel(first);
+            registry.cancel(second);
+            auto fourth = registry.add([&] (int value) { calls.push_back(-value); });
+
+            THEN("remaining handles must still be valid") {
+                REQUIRE(registry.size() == 2);
+                REQUIRE(registry.contains(third));
+                REQUIRE(registry.contains(fourth));
+            }
+
+            AND_WHEN("it is dispatched") {
+                registry.dispatch(1);
+
+                THEN("remaining handlers must have been invoked in insertion order") {
+                    REQUIRE(calls == std::vector<int> { 100, -1 });
+                }
+            }
+
+            AND_WHEN("a remaining handler is cancelled") {
+                registry.cancel(fourth);
+                registry.dispatch(1);
+
+                THEN("only the other one must have been invoked") {
+                    REQUIRE(calls == std::vector<int> { 100 });
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("handlers can subscribe and cancel other handlers while a message is shouted", "[fuss]") {
+    GIVEN("a shouter") {
+        struct msg : public fuss::message<> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        test_shouter shouter;
+        std::vector<int> calls;
+        fuss::listener second;
+
+        shouter.listen<msg>([&] {
+            calls.push_back(1);
+            second.cancel();
+            shouter.listen<msg>([&] { calls.push_back(3); });
+        });
+        second = shouter.listen<msg>([&] { calls.push_back(2); });
+
+        WHEN("it shouts") {
+            shouter.shout<msg>();
+
+            THEN("the cancelled handler must not have been invoked") {
+                REQUIRE(calls == std::vector<int> { 1 });
+            }
+
+            AND_WHEN("it shouts again") {
+                calls.clear();
+                shouter.shout<msg>();
+
+                THEN("the handler added during the first shout must have been invoked") {
+                    REQUIRE(calls == std::vector<int> { 1, 3 });
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("handlers can cancel themselves while being invoked", "[fuss]") {
+    GIVEN("a shouter") {
+        struct msg : public fuss::message<int> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        test_shouter shouter;
+        auto token = std::make_shared<int>(0);
+        std::vector<int> calls;
+
+        AND_GIVEN("a handler that cancels itself and then uses its captures") {
+            fuss::listener self;
+            self = shouter.listen<msg>([&, token] (int value) {
+                self.cancel();
+                *token += value;
+                calls.push_back(value);
+            });
+            shouter.listen<msg>([&] (int value) { calls.push_back(-value); });
+
+            WHEN("the message is shouted") {
+                shouter.shout<msg>(1);
+
+                THEN("every handler must have been invoked once") {
+                    REQUIRE(calls == std::vector<int> { 1, -1 });
+                    REQUIRE(*token == 1);
+                }
+
+                THEN("the cancelled handler must have been destroyed") {
+                    REQUIRE(token.use_count() == 1);
+                }
+
+                AND_WHEN("the message is shouted again") {
+                    shouter.shout<msg>(2);
+
+                    THEN("only the remaining handler must have been invoked") {
+                        REQUIRE(calls == std::vector<int> { 1, -1, -2 });
+                    }
+                }
+            }
+        }
+
+        AND_GIVEN("a handler that shouts again and cancels itself") {
+            fuss::listener self;
+            self = shouter.listen<msg>([&, token] (int value) {
+                calls.push_back(value);
+                if(value > 0) {
+                    self.cancel();
+                    shouter.shout<msg>(value - 1);
+                }
+            });
+
+            WHEN("the message is shouted") {
+                shouter.shout<msg>(3);
+
+                THEN("the nested shout must not have invoked the cancelled handler") {
+                    REQUIRE(calls == std::vector<int> { 3 });
+                }
+
+                THEN("the cancelled handler must have been destroyed") {
+                    REQUIRE(token.use_count() == 1);
+                }
+            }
+        }
+
+        AND_GIVEN("a handler that subscribes another and then throws") {
+            shouter.listen<msg>([&] (int) {
+                shouter.listen<msg>([&] (int value) { calls.push_back(value); });
+                throw std::runtime_error { "handler exception"s };
+            });
+
+            WHEN("the message is shouted") {
+                auto shout_result = attempt([&] { shouter.shout<msg>(1); });
+
+                THEN("the exception must have been propagated") {
+                    REQUIRE(shout_result.holds_error<std::runtime_error>());
+                }
+
+                THEN("the subscription made during the shout must be effective") {
+                    REQUIRE(shouter.handlers.size() == 2);
+                }
+            }
+        }
+
+        AND_GIVEN("a handler whose destruction cancels another handler") {
+            auto other = shouter.listen<msg>([&] (int value) { calls.push_back(value); });
+            fuss::listener self;
+            self = shouter.listen<msg>(
+                [&, guard = std::make_shared<fuss::message_guard>(other)] (int) {
+                    self.cancel();
+                }
+            );
+
+            WHEN("the message is shouted") {
+                shouter.shout<msg>(1);
+
+                THEN("both handlers must have been removed") {
+                    REQUIRE(calls == std::vector<int> { 1 });
+                    REQUIRE(shouter.handlers.empty());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("a bus delivers messages to handlers in their event loops", "[fuss]") {
+    GIVEN("a bus and two event loops") {
+        struct msg : public fuss::message<int, std::string> {  };
+        fuss::bus<msg> bus { 4 };
+        fugax::event_loop loop_1;
+        fugax::event_loop loop_2;
+
+        std::vector<int> received_1;
+        std::vector<int> received_2;
+
+        AND_GIVEN("a handler attached to each loop") {
+            bus.listen<msg>(loop_1, [&] (int value, const std::string &) {
+                received_1.push_back(value);
+            });
+            bus.listen<msg>(loop_2, [&] (int value, const std::string &) {
+                received_2.push_back(value);
+            });
+
+            WHEN("messages are shouted") {
+                auto queued = bus.shout<msg>(1, "one"s) && bus.shout<msg>(2, "two"s);
+
+                THEN("they must have been queued") {
+                    REQUIRE(queued);
+                }
+
+                THEN("no handler must have been invoked yet") {
+                    REQUIRE(received_1.empty());
+                    REQUIRE(received_2.empty());
+                }
+
+                AND_WHEN("one of the loops is processed") {
+                    loop_1.process(0);
+
+                    THEN("only its handler must have received the whole batch") {
+                        REQUIRE(received_1 == std::vector<int> { 1, 2 });
+                        REQUIRE(received_2.empty());
+                    }
+                }
+            }
+
+            WHEN("more messages are shouted than a station can hold") {
+                bool queued = true;
+                for(int i = 0; i < 5; i++) {
+                    queued = bus.shout<msg>(i, "value"s) && queued;
+                }
+
+                THEN("shouting must have failed") {
+                    REQUIRE_FALSE(queued);
+                }
+
+                AND_WHEN("the loops are processed") {
+                    loop_1.process(0);
+                    loop_2.process(0);
+
+                    THEN("the queued messages must have been delivered") {
+                        REQUIRE(received_1 == std::vector<int> { 0, 1, 2, 3 });
+                        REQUIRE(received_2 == std::vector<int> { 0, 1, 2, 3 });
+                    }
+                }
+            }
+
+            WHEN("every handler of a loop is cancelled and the loop is destroyed") {
+                auto transient = std::make_unique<fugax::event_loop>();
+                int transient_calls = 0;
+                auto listener = bus.listen<msg>(*transient, [&] (int, const std::string &) {
+                    transient_calls++;
+                });
+                listener.cancel();
+                transient.reset();
+
+                auto queued = bus.shout<msg>(3, "three"s);
+                loop_1.process(0);
+
+                THEN("shouting must only reach the remaining loops") {
+                    REQUIRE(queued);
+                    REQUIRE(received_1 == std::vector<int> { 3 });
+                    REQUIRE(transient_calls == 0);
+                }
+            }
+
+            WHEN("the bus is destroyed while a drain is pending in a loop") {
+                auto transient_bus = std::make_unique<fuss::bus<msg>>();
+                int transient_calls = 0;
+                auto listener = transient_bus->listen<msg>(loop_1, [&] (int, const std::string &) {
+                    transient_calls++;
+                });
+                transient_bus->shout<msg>(5, "five"s);
+                transient_bus.reset();
+
+                AND_WHEN("the handler is cancelled and the loop is processed") {
+                    listener.cancel();
+                    loop_1.process(0);
+
+                    THEN("the handler must not have been invoked") {
+                        REQUIRE(transient_calls == 0);
+                    }
+                }
+
+                AND_WHEN("the loop is processed") {
+                    loop_1.process(0);
+
+                    THEN("the pending message must still have been delivered") {
+                        REQUIRE(transient_calls == 1);
+                        listener.cancel();
+                    }
+                }
+            }
+
+            WHEN("messages are shouted from several threads") {
+                constexpr int count = 1000;
+                fuss::bus<msg> threaded_bus { count * 2 };
+                std::vector<std::pair<int, int>> received;
+                threaded_bus.listen<msg>(loop_1, [&] (int value, const std::string &origin) {
+                    received.emplace_back(origin == "first"s ? 0 : 1, value);
+                });
+
+                std::thread first { [&] {
+                    for(int i = 0; i < count; i++) threaded_bus.shout<msg>(i, "first"s);
+                } };
+                std::thread second { [&] {
+                    for(int i = 0; i < count; i++) threaded_bus.shout<msg>(i, "second"s);
+                } };
+                first.join();
+                second.join();
+                loop_1.process(0);
+
+                THEN("every message must have been delivered in the order it was shouted") {
+                    REQUIRE(received.size() == count * 2);
+
+                    int next[2] = { 0, 0 };
+                    bool ordered = true;
+                    for(auto &[origin, value] : received) {
+                        ordered = ordered && value == next[origin]++;
+                    }
+                    REQUIRE(ordered);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("a static shouter invokes handlers fixed at compile time", "[fuss]") {
+    GIVEN("a static shouter with two handlers") {
+        struct msg : public fuss::message<int> {  };
+        std::vector<int> calls;
+
+        auto shouter = fuss::make_static_shouter<msg>(
+            [&] (int value) { calls.push_back(value); },
+            [&, owned = std::make_unique<int>(10)] (int value) {
+                calls.push_back(value * *owned);
+            }
+        );
+
+        WHEN("it shouts") {
+            shouter.shout<msg>(2);
+
+            THEN("both handlers must have been invoked in order") {
+                REQUIRE(calls == std::vector<int> { 2, 20 });
+            }
+        }
+    }
+
+    GIVEN("a static shouter used in a constant expression") {
+        THEN("its handlers must have been invoked at compile time") {
+            STATIC_REQUIRE(static_sum(2) == 22);
+        }
+    }
+}
+
+SCENARIO("handlers can be attached for a single key of a keyed message", "[fuss]") {
+    GIVEN("a shouter of a keyed message") {
+        struct data_available : public fuss::keyed_message<int, std::string> {  };
+        struct test_shouter : public fuss::shouter<data_available> {  };
+
+        test_shouter shouter;
+        std::vector<std::string> calls;
+
+        AND_GIVEN("a handler for any key and handlers for keys 1 and 2") {
+            shouter.listen<data_available>([&] (int key, const std::string &data) {
+                calls.push_back("any:"s + std::to_string(key) + ":"s + data);
+            });
+            auto listener_1 = shouter.listen<data_available>(1, [&] (int, const std::string &data) {
+                calls.push_back("1:"s + data);
+            });
+            shouter.listen<data_available>(2, [&] (int, const std::string &data) {
+                calls.push_back("2:"s + data);
+            });
+
+            WHEN("key 1 is shouted") {
+                shouter.shout<data_available>(1, "data"s);
+
+                THEN("only the handler for any key and the one for key 1 must have been invoked") {
+                    REQUIRE(calls == std::vector<std::string> { "any:1:data"s, "1:data"s });
+                }
+            }
+
+            WHEN("a key without handlers is shouted") {
+                shouter.shout<data_available>(3, "data"s);
+
+                THEN("only the handler for any key must have been invoked") {
+                    REQUIRE(calls == std::vector<std::string> { "any:3:data"s });
+                }
+            }
+
+            WHEN("the handler for key 1 is cancelled") {
+                listener_1.cancel();
+                shouter.shout<data_available>(1, "data"s);
+
+                THEN("it must not have been invoked") {
+                    REQUIRE(calls == std::vector<std::string> { "any:1:data"s });
+                }
+
+                AND_WHEN("a new handler is attached for key 1") {
+                    shouter.listen<data_available>(1, [&] (int, const std::string &data) {
+                        calls.push_back("new 1:"s + data);
+                    });
+                    shouter.shout<data_available>(1, "more"s);
+
+                    THEN("it must have been invoked") {
+                        REQUIRE(calls.back() == "new 1:more"s);
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a group including a keyed message") {
+        struct keyed : public fuss::keyed_message<std::string> {  };
+        struct plain : public fuss::message<> {  };
+        struct test_group : public fuss::group<fuss::shouter<keyed>, fuss::shouter<plain>> {  };
+
+        test_group shouter;
+        int count = 0;
+        shouter.listen<keyed>("key"s, [&] (const std::string &) { count++; });
+
+        WHEN("the key is shouted") {
+            shouter.shout<keyed>("key"s);
+            shouter.shout<keyed>("other"s);
+
+            THEN("the handler must have been invoked once") {
+                REQUIRE(count == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("shouted arguments are not copied needlessly", "[fuss]") {
+    GIVEN("a shouter of a message delivered by value, with three handlers") {
+        struct msg : public fuss::message<tracked> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        test_shouter shouter;
+        for(int i = 0; i < 3; i++) {
+            shouter.listen<msg>([] (tracked) {  });
+        }
+
+        WHEN("an rvalue is shouted") {
+            tracked::copies = 0;
+            shouter.shout<msg>(tracked {  });
+
+            THEN("it must have been moved into the last handler") {
+                REQUIRE(tracked::copies == 2);
+            }
+        }
+
+        WHEN("an lvalue is shouted") {
+            tracked value;
+            tracked::copies = 0;
+            shouter.shout<msg>(value);
+
+            THEN("every handler must have received its own copy") {
+                REQUIRE(tracked::copies == 3);
+            }
+        }
+    }
+
+    GIVEN("a shouter of a message delivered by reference, with three handlers") {
+        struct msg : public fuss::ref_message<tracked> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        test_shouter shouter;
+        const tracked *received = nullptr;
+        for(int i = 0; i < 3; i++) {
+            shouter.listen<msg>([&] (const tracked &value) { received = &value; });
+        }
+
+        WHEN("an lvalue is shouted") {
+            tracked value;
+            tracked::copies = 0;
+            shouter.shout<msg>(value);
+
+            THEN("no copy must have been made") {
+                REQUIRE(tracked::copies == 0);
+                REQUIRE(received == &value);
+            }
+        }
+    }
+}
+
+SCENARIO("listeners can be cancelled after their shouter is gone", "[fuss]") {
+    GIVEN("a listener and a message guard of a shouter that is destroyed") {
+        struct msg : public fuss::message<> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        int count = 0;
+        fuss::listener listener;
+        std::optional<fuss::message_guard> guard;
+        {
+            test_shouter shouter;
+            listener = shouter.listen<msg>([&] { count++; });
+            guard.emplace(shouter.listen<msg>([&] { count++; }));
+        }
+
+        WHEN("a new shouter is created in its place and listened to") {
+            test_shouter shouter;
+            shouter.listen<msg>([&] { count++; });
+
+            AND_WHEN("the stale listener and guard are cancelled") {
+                auto cancel_result = attempt([&] {
+                    listener.cancel();
+                    guard.reset();
+                });
+
+                THEN("no exception must have been thrown") {
+                    REQUIRE_FALSE(cancel_result.has_error());
+                }
+
+                THEN("the new shouter's handler must not have been cancelled") {
+                    shouter.shout<msg>();
+                    REQUIRE(count == 1);
+                }
+            }
+        }
+    }
+
+    GIVEN("a shouter and a listener copied many times") {
+        struct msg : public fuss::message<> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        test_shouter shouter;
+        int count = 0;
+        auto listener = shouter.listen<msg>([&] { count++; });
+        std::vector<fuss::listener> copies(16, listener);
+
+        WHEN("every copy is cancelled") {
+            for(auto &copy : copies) copy.cancel();
+            shouter.shout<msg>();
+
+            THEN("the handler must have been cancelled once and not invoked") {
+                REQUIRE(count == 0);
+                REQUIRE(shouter.handlers.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("shouters can be created and destroyed concurrently", "[fuss]") {
+    GIVEN("several threads that each create, listen to and destroy shouters") {
+        struct msg : public fuss::message<> {  };
+        struct test_shouter : public fuss::shouter<msg> {  };
+
+        constexpr int thread_count = 4;
+        constexpr int round_count = 2000;
+        std::atomic<int> failures = 0;
+
+        WHEN("they run at the same time") {
+            std::vector<std::thread> threads;
+            for(int i = 0; i < thread_count; i++) {
+                threads.emplace_back([&] {
+                    for(int round = 0; round < round_count; round++) {
+                        int count = 0;
+                        fuss::listener stale;
+                        {
+                            test_shouter shouter;
+                            auto listener = shouter.listen<msg>([&] { count++; });
+                            stale = shouter.listen<msg>([&] { count++; });
+                            listener.cancel();
+                            shouter.shout<msg>();
+                        }
+                        stale.cancel();
+                        if(count != 1) failures++;
+                    }
+                });
+            }
+            for(auto &thread : threads) thread.join();
+
+            THEN("each shouter must have reached only its own handlers") {
+                REQUIRE(failures == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("a coalescing shouter delivers only the latest message", "[fuss]") {
+    GIVEN("an event loop and a coalescing shouter with a listener") {
+        struct state : public fuss::message<int> {  };
+        fugax::event_loop loop;
+        std::vector<int> received;
+
+        AND_GIVEN("no minimum interval") {
+            fuss::coalescing<state> shouter { loop };
+            shouter.listen<state>([&] (int value) { received.push_back(value); });
+
+            WHEN("a burst of messages is shouted") {
+                for(int i = 1; i <= 100; i++) shouter.shout<state>(i);
+
+                THEN("no message must have been delivered yet") {
+                    REQUIRE(received.empty());
+                    REQUIRE(shouter.pending());
+                }
+
+                AND_WHEN("the loop is processed") {
+                    loop.process(0);
+
+                    THEN("only the latest message must have been delivered") {
+                        REQUIRE(received == std::vector<int> { 100 });
+                        REQUIRE_FALSE(shouter.pending());
+                    }
+
+                    AND_WHEN("another message is shouted and the loop processed") {
+                        shouter.shout<state>(101);
+                        loop.process(0);
+
+                        THEN("it must have been delivered in the next tick") {
+                            REQUIRE(received == std::vector<int> { 100, 101 });
+                        }
+                    }
+                }
+
+                AND_WHEN("it is flushed") {
+                    shouter.flush();
+                    loop.process(0);
+
+                    THEN("the latest message must have been delivered only once") {
+                        REQUIRE(received == std::vector<int> { 100 });
+                    }
+                }
+            }
+        }
+
+        AND_GIVEN("a minimum interval") {
+            fuss::coalescing<state> shouter { loop, 10 };
+            shouter.listen<state>([&] (int value) { received.push_back(value); });
+
+            WHEN("messages are shouted over time") {
+                shouter.shout<state>(1);
+                loop.process(5);
+                shouter.shout<state>(2);
+                loop.process(9);
+
+                THEN("nothing must have been delivered before the interval") {
+                    REQUIRE(received.empty());
+                }
+
+                AND_WHEN("the interval passes") {
+                    loop.process(10);
+
+                    THEN("the latest message must have been delivered") {
+                        REQUIRE(received == std::vector<int> { 2 });
+                    }
+                }
+            }
+        }
+
+        AND_GIVEN("a coalescing shouter destroyed with a pending message") {
+            {
+                fuss::coalescing<state> shouter { loop };
+                shouter.listen<state>([&] (int value) { received.push_back(value); });
+                shouter.shout<state>(1);
+            }
+
+            WHEN("the loop is processed") {
+                loop.process(0);
+
+                THEN("nothing must have been delivered") {
+                    REQUIRE(received.empty());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("handlers are invoked in priority order", "[fuss]") {
+    GIVEN("a shouter with handlers of different priorities") {
+        struct test_shouter : public fuss::shouter<summed> {  };
+
+        test_shouter shouter;
+        std::vector<std::string> calls;
+
+        shouter.listen<summed>([&] (int) { calls.push_back("default"s); });
+        shouter.listen<summed>([&] (int) { calls.push_back("high 1"s); }, fuss::priority { 10 });
+        shouter.listen<summed>([&] (int) { calls.push_back("low"s); }, fuss::priority { -5 });
+        shouter.listen<summed>([&] (int) { calls.push_back("high 2"s); }, fuss::priority { 10 });
+
+        WHEN("a message is shouted") {
+            shouter.shout<summed>(1);
+
+            THEN("handlers must have been invoked by priority, then by subscription order") {
+                REQUIRE(calls == std::vector<std::string> { "high 1"s, "high 2"s, "default"s, "low"s });
+            }
+        }
+
+        WHEN("a higher priority handler is attached while the message is shouted") {
+            bool attached = false;
+            shouter.listen<summed>([&] (int) {
+                if(!attached) {
+                    attached = true;
+                    shouter.listen<summed>([&] (int) { calls.push_back("urgent"s); }, fuss::priority { 20 });
+                }
+            }, fuss::priority { -10 });
+
+            shouter.shout<summed>(1);
+            calls.clear();
+            shouter.shout<summed>(1);
+
+            THEN("it must be invoked first in the next shout") {
+                REQUIRE(calls == std::vector<std::string> { "urgent"s, "high 1"s, "high 2"s, "default"s, "low"s });
+            }
+        }
+    }
+
+    GIVEN("a shouter of a keyed message") {
+        struct data_available : public fuss::keyed_message<int, int> {  };
+        struct test_shouter : public fuss::shouter<data_available> {  };
+
+        test_shouter shouter;
+        std::vector<std::string> calls;
+
+        shouter.listen<data_available>(1, [&] (int, int) { calls.push_back("late"s); }, fuss::priority { -1 });
+        shouter.listen<data_available>(1, [&] (int, int) { calls.push_back("early"s); }, fuss::priority { 1 });
+
+        WHEN("the key is shouted") {
+            shouter.shout<data_available>(1, 0);
+
+            THEN("its handlers must have been invoked by priority") {
+                REQUIRE(calls == std::vector<std::string> { "early"s, "late"s });
+            }
+        }
+    }
+}
+
+SCENARIO("handlers can be deferred onto an event loop", "[fuss]") {
+    GIVEN("a shouter with an immediate and a deferred handler") {
+        struct test_shouter : public fuss::shouter<summed> {  };
+
+        fugax::event_loop loop;
+        test_shouter shouter;
+        std::vector<int> immediate;
+        std::vector<int> deferred;
+
+        shouter.listen<summed>([&] (int value) { immediate.push_back(value); }, fuss::priority { 1 });
+        auto listener = shouter.listen<summed>(
+            fuss::deferred(loop, [&] (int value) { deferred.push_back(value); })
+        );
+
+        WHEN("messages are shouted") {
+            shouter.shout<summed>(1);
+            shouter.shout<summed>(2);
+
+            THEN("only the immediate handler must have been invoked") {
+                REQUIRE(immediate == std::vector<int> { 1, 2 });
+                REQUIRE(deferred.empty());
+            }
+
+            AND_WHEN("the loop is processed") {
+                loop.process(0);
+
+                THEN("the deferred handler must have been invoked in order") {
+                    REQUIRE(deferred == std::vector<int> { 1, 2 });
+                }
+            }
+
+            AND_WHEN("the deferred handler is cancelled before the loop is processed") {
+                listener.cancel();
+                loop.process(0);
+
+                THEN("it must not have been invoked") {
+                    REQUIRE(deferred.empty());
+                }
+            }
+        }
+    }
+}
@@ -1,10 +1,20 @@
 #define JURO_TEST
 
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
 #include <type_traits>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 #include <utils/test-helpers.hpp>
 #include "juro/promise.hpp"
+#include "juro/atomic-promise.hpp"
+#include "juro/pool-allocator.hpp"
 #include "juro/compose/all.hpp"
 #include "juro/compose/race.hpp"
 
@@ -12,6 +22,84 @@ using namespace juro::helpers;
 using namespace std::string_literals;
 using namespace utils::test_helpers;
 
+namespace {
+
+/**
+ * @brief How many blocks the calling thread has obtained from the global
+ * heap, as counted by the replaced `operator new` below
+ */
+thread_local std::size_t global_allocations = 0;
+
+} /* anonymous namespace */
+
+// The replacements pair malloc() with free(), which GCC cannot tell apart
+// from mixing them with the replaced operators once they are inlined
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+    global_allocations++;
+    if(void *block = std::malloc(size == 0 ? 1 : size)) return block;
+    throw std::bad_alloc {  };
+}
+
+void operator delete(void *block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept {
+    std::free(block);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+/**
+ * @brief A dispatcher that runs tasks at once, in the calling thread
+ */
+void run_at_once(std::function<void()> task) {
+    task();
+}
+
+/**
+ * @brief A dispatcher that queues tasks, from any thread, until the owning
+ * thread runs them
+ */
+struct task_queue {
+    std::mutex mutex;
+    std::vector<std::function<void()>> tasks;
+
+    juro::dispatcher dispatcher() {
+        return [this] (std::function<void()> task) {
+            std::lock_guard lock { mutex };
+            tasks.push_back(std::move(task));
+        };
+    }
+
+    void run() {
+        std::vector<std::function<void()>> pending;
+        {
+            std::lock_guard lock { mutex };
+            pending.swap(tasks);
+        }
+        for(auto &task : pending) task();
+    }
+};
+
+/**
+ * @brief A value whose conversion to a string fails
+ */
+struct unconvertible {
+    operator std::string() const { throw std::runtime_error { "Conversion failed" }; }
+};
+
+} /* anonymous namespace */
+
 SCENARIO("a promise can be created in every state", "[juro]") {
     GIVEN("a pending promise factory function") {
         WHEN("it is called with no parameter") {
@@ -776,4 +864,538 @@ SCENARIO("multiple promises can be composed", "[juro]") {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+SCENARIO("an atomic promise can be settled from another thread", "[juro]") {
+    GIVEN("an empty dispatcher") {
+        THEN("no atomic promise can be created with it") {
+            auto result = attempt([] { juro::make_atomic<int>(juro::dispatcher {  }); });
+            REQUIRE(result.holds_error<promise_error>());
+        }
+    }
+
+    GIVEN("a pending atomic promise of a string") {
+        auto promise = juro::make_atomic<std::string>(run_at_once);
+
+        WHEN("resolving it fails while storing the value") {
+            auto result = attempt([&] { promise->resolve(unconvertible {  }); });
+
+            THEN("it must still be pending, and settle normally later") {
+                REQUIRE(result.holds_error<std::runtime_error>());
+                REQUIRE(promise->is_pending());
+
+                std::string resolved_value;
+                promise->then([&] (const std::string &value) { resolved_value = value; });
+                promise->resolve("done"s);
+                REQUIRE(resolved_value == "done"s);
+            }
+        }
+    }
+
+    GIVEN("a pending atomic promise") {
+        auto promise = juro::make_atomic<int>(run_at_once);
+
+        THEN("it must be pending") {
+            REQUIRE(promise->is_pending());
+        }
+
+        WHEN("it is resolved before a handler is attached") {
+            promise->resolve(10);
+
+            THEN("it must be resolved") {
+                REQUIRE(promise->is_resolved());
+            }
+
+            AND_WHEN("a handler is attached") {
+                int resolved_value = 0;
+                auto next = promise->then([&] (int value) {
+                    resolved_value = value;
+                });
+
+                THEN("the handler must have been invoked immediately") {
+                    REQUIRE(resolved_value == 10);
+                    REQUIRE(next->is_resolved());
+                }
+
+                AND_WHEN("another handler is attached") {
+                    auto result = attempt([&] {
+                        promise->then([] (int) {  });
+                    });
+
+                    THEN("a `promise_error` must be thrown") {
+                        REQUIRE(result.holds_error<promise_error>());
+                    }
+                }
+            }
+        }
+
+        WHEN("it is rejected before a handler is attached") {
+            auto result = attempt([&] { promise->reject("Rejected"s); });
+
+            THEN("no exception must be thrown") {
+                REQUIRE_FALSE(result.has_error());
+                REQUIRE(promise->is_rejected());
+            }
+
+            AND_WHEN("a reject handler is attached") {
+                std::string rescued_string;
+                promise->rescue([&] (std::exception_ptr &error) {
+                    rescued_string = rescue(error).get_error<std::string>();
+                    return 0;
+                });
+
+                THEN("the handler must have been invoked immediately") {
+                    REQUIRE(rescued_string == "Rejected"s);
+                }
+            }
+        }
+
+        WHEN("a handler is attached before it is resolved") {
+            int resolved_value = 0;
+            auto next = promise->then([&] (int value) { 
+                resolved_value = value; 
+            });
+
+            THEN("the handler must not have been invoked") {
+                REQUIRE(next->is_pending());
+            }
+
+            AND_WHEN("it is resolved") {
+                promise->resolve(20);
+
+                THEN("the handler must have been invoked") {
+                    REQUIRE(resolved_value == 20);
+                    REQUIRE(next->is_resolved());
+                }
+
+                AND_WHEN("it is resolved again") {
+                    auto result = attempt([&] { promise->resolve(30); });
+
+                    THEN("a `promise_error` must be thrown") {
+                        REQUIRE(result.holds_error<promise_error>());
+                        REQUIRE(result.get_error<promise_error>().what() ==
+                            "Attempted to resolve an already settled promise"s
+                        );
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("many atomic promises resolved in a worker thread") {
+        constexpr std::size_t count = 1000;
+        task_queue queue;
+        std::vector<juro::atomic_promise_ptr<int>> promises;
+        for(std::size_t i = 0; i < count; i++) {
+            promises.push_back(juro::make_atomic<int>(queue.dispatcher()));
+        }
+
+        std::thread worker { [&] {
+            for(std::size_t i = 0; i < count; i++) {
+                promises[i]->resolve(static_cast<int>(i));
+            }
+        } };
+
+        WHEN("handlers are concurrently attached in this thread") {
+            std::vector<int> values(count, -1);
+            for(std::size_t i = 0; i < count; i++) {
+                promises[i]->then([&values, i] (int value) { values[i] = value; });
+            }
+            worker.join();
+            queue.run();
+
+            THEN("every handler must have been invoked exactly with its value") {
+                for(std::size_t i = 0; i < count; i++) {
+                    REQUIRE(values[i] == static_cast<int>(i));
+                }
+            }
+        }
+    }
+}
+
+
+SCENARIO("long promise chains can be settled iteratively", "[juro]") {
+    GIVEN("a long chain of promises that records the stack depth of each handler") {
+        constexpr std::size_t length = 1000;
+        std::vector<std::uintptr_t> depths;
+
+        auto head = juro::make_pending<int>();
+        juro::promise_ptr<int> tail = head;
+        for(std::size_t i = 0; i < length; i++) {
+            tail = tail->then([&] (int value) {
+                int local = 0;
+                depths.push_back(reinterpret_cast<std::uintptr_t>(&local));
+                return value + 1;
+            });
+        }
+
+        WHEN("the head is resolved in iterative dispatch mode") {
+            juro::set_dispatch_mode(dispatch_mode::ITERATIVE);
+            auto result = attempt([&] { head->resolve(0); });
+            juro::set_dispatch_mode(dispatch_mode::RECURSIVE);
+
+            THEN("no exception must have been thrown") {
+                REQUIRE_FALSE(result.has_error());
+            }
+
+            THEN("every handler must have been invoked in order") {
+                REQUIRE(depths.size() == length);
+                REQUIRE(tail->is_resolved());
+                REQUIRE(tail->get_value() == static_cast<int>(length));
+            }
+
+            THEN("every handler must have run at the same stack depth") {
+                REQUIRE(depths.front() == depths.back());
+            }
+        }
+
+        WHEN("the head is resolved in recursive dispatch mode") {
+            head->resolve(0);
+
+            THEN("the chain must have been settled likewise") {
+                REQUIRE(depths.size() == length);
+                REQUIRE(tail->get_value() == static_cast<int>(length));
+            }
+
+            THEN("the stack must have grown along the chain") {
+                REQUIRE(depths.front() != depths.back());
+            }
+        }
+    }
+
+    GIVEN("a promise settled from inside a handler and dropped right after") {
+        auto head = juro::make_pending();
+        bool inner_handled = false;
+        head->then([&] {
+            auto inner = juro::make_pending();
+            inner->then([&] { inner_handled = true; });
+            inner->resolve();
+        });
+
+        WHEN("the head is resolved in iterative dispatch mode") {
+            juro::set_dispatch_mode(dispatch_mode::ITERATIVE);
+            head->resolve();
+            juro::set_dispatch_mode(dispatch_mode::RECURSIVE);
+
+            THEN("the inner promise handler must have been invoked") {
+                REQUIRE(inner_handled);
+            }
+        }
+    }
+}
+
+
+namespace {
+
+struct payload {
+    static inline int copies = 0;
+    std::vector<int> data;
+
+    payload(std::vector<int> data) : data { std::move(data) } {  }
+    payload(const payload &other) : data { other.data } { copies++; }
+    payload(payload &&) noexcept = default;
+    payload &operator=(const payload &other) {
+        data = other.data;
+        copies++;
+        return *this;
+    }
+    payload &operator=(payload &&) noexcept = default;
+};
+
+} /* anonymous namespace */
+
+SCENARIO("resolved values can be moved along a promise chain", "[juro]") {
+    GIVEN("a pending promise of a payload that counts its copies") {
+        payload::copies = 0;
+        auto promise = juro::make_pending<payload>();
+
+        WHEN("values are moved through a chain with `then_move()`") {
+            auto next = promise
+                ->then_move([] (payload &&value) { 
+                    value.data.push_back(4);
+                    return std::move(value); 
+                })
+                ->then_move([] (payload value) { return value; });
+
+            promise->resolve(payload { { 1, 2, 3 } });
+
+            THEN("the last promise must hold the value") {
+                REQUIRE(next->is_resolved());
+                REQUIRE(next->get_value().data == std::vector { 1, 2, 3, 4 });
+            }
+
+            THEN("the value must never have been copied") {
+                REQUIRE(payload::copies == 0);
+            }
+        }
+
+        WHEN("the value is shared") {
+            auto shared = promise->share();
+            std::vector<std::shared_ptr<const payload>> consumers;
+            shared->then([&] (auto &value) {
+                for(int i = 0; i < 3; i++) consumers.push_back(value);
+            });
+
+            promise->resolve(payload { { 1, 2, 3 } });
+
+            THEN("every consumer must refer to the same immutable value") {
+                REQUIRE(consumers.size() == 3);
+                REQUIRE(consumers[0] == consumers[1]);
+                REQUIRE(consumers[1] == consumers[2]);
+                REQUIRE(consumers[0]->data == std::vector { 1, 2, 3 });
+            }
+
+            THEN("the value must never have been copied") {
+                REQUIRE(payload::copies == 0);
+            }
+        }
+
+        WHEN("the promise is rejected after a `then_move()` handler is attached") {
+            auto next = promise->then_move([] (payload &&value) { return std::move(value); });
+            auto result = attempt([&] { promise->reject("Rejected"s); });
+
+            THEN("the rejection must be propagated down the chain") {
+                REQUIRE(next->is_rejected());
+                REQUIRE(rescue(next->get_error()).get_error<std::string>() == "Rejected"s);
+            }
+        }
+    }
+
+    GIVEN("a promise of a move-only type") {
+        auto promise = juro::make_pending<std::unique_ptr<int>>();
+        auto next = promise->then_move([] (std::unique_ptr<int> &&value) {
+            return std::move(value);
+        });
+
+        WHEN("it is resolved") {
+            promise->resolve(std::make_unique<int>(10));
+
+            THEN("the value must have been moved into the chained promise") {
+                REQUIRE(next->is_resolved());
+                REQUIRE(*next->get_value() == 10);
+                REQUIRE(promise->get_value() == nullptr);
+            }
+        }
+    }
+}
+
+
+SCENARIO("promises can be allocated from a pool", "[juro]") {
+    GIVEN("a size class pool") {
+        const auto available = juro::size_class_pool::available(24);
+
+        WHEN("a block is allocated and deallocated") {
+            void *block = juro::size_class_pool::allocate(24, alignof(std::max_align_t));
+            juro::size_class_pool::deallocate(block, 24, alignof(std::max_align_t));
+
+            THEN("the block must be available in the free list of its size class") {
+                REQUIRE(juro::size_class_pool::available(24) == available + 1);
+                REQUIRE(juro::size_class_pool::available(32) == available + 1);
+            }
+
+            AND_WHEN("a block of the same size class is allocated") {
+                const auto free_blocks = juro::size_class_pool::available(30);
+                void *other = juro::size_class_pool::allocate(30, alignof(int));
+
+                THEN("the free block must be reused") {
+                    REQUIRE(other == block);
+                    REQUIRE(juro::size_class_pool::available(30) == free_blocks - 1);
+                }
+
+                juro::size_class_pool::deallocate(other, 30, alignof(int));
+            }
+        }
+    }
+
+    GIVEN("a size class pool fed with blocks allocated in another thread") {
+        constexpr std::size_t count = juro::size_class_pool::max_free * 2;
+        std::vector<void *> blocks(count);
+        std::thread { [&] {
+            for(auto &block : blocks) {
+                block = juro::size_class_pool::allocate(48, alignof(int));
+            }
+        } }.join();
+
+        WHEN("all of them are deallocated in this thread") {
+            for(void *block : blocks) {
+                juro::size_class_pool::deallocate(block, 48, alignof(int));
+            }
+
+            THEN("the free list of their size class must not grow past its cap") {
+                REQUIRE(juro::size_class_pool::available(48) == juro::size_class_pool::max_free);
+            }
+        }
+    }
+
+    GIVEN("a thread-local promise allocated from the pool before the free lists of its thread") {
+        struct holder {
+            juro::promise_ptr<int> promise;
+        };
+
+        WHEN("the thread exits and destroys the free lists first") {
+            std::thread { [] {
+                thread_local holder local;
+                local.promise = juro::make_pending<int>(std::allocator_arg, juro::pool_allocator<int> {  });
+            } }.join();
+
+            THEN("the promise must have been released without touching them") {
+                SUCCEED();
+            }
+        }
+    }
+
+    GIVEN("a pool allocator") {
+        juro::pool_allocator<int> allocator;
+
+        THEN("it must be the pool allocator of utils") {
+            STATIC_REQUIRE(std::is_same_v<juro::pool_allocator<int>, utils::pool_allocator<int>>);
+        }
+
+        WHEN("promises are created in every state with it") {
+            auto pending = juro::make_pending<int>(std::allocator_arg, allocator);
+            auto launched = juro::make_promise<int>(std::allocator_arg, allocator, [] (auto &promise) {
+                promise->resolve(10);
+            });
+            auto resolved = juro::make_resolved(std::allocator_arg, allocator, 20);
+            auto resolved_void = juro::make_resolved(std::allocator_arg, allocator);
+            auto rejected = juro::make_rejected<int>(std::allocator_arg, allocator, "Rejected"s);
+
+            THEN("they must behave like any other promise") {
+                REQUIRE(pending->is_pending());
+                REQUIRE(launched->get_value() == 10);
+                REQUIRE(resolved->get_value() == 20);
+                REQUIRE(resolved_void->is_resolved());
+                REQUIRE(rescue(rejected->get_error()).get_error<std::string>() == "Rejected"s);
+            }
+
+            AND_WHEN("a promise is released") {
+                const void *address = pending.get();
+                pending.reset();
+
+                AND_WHEN("another promise of the same type is created") {
+                    auto next = juro::make_pending<int>(std::allocator_arg, allocator);
+
+                    THEN("it must reuse the released storage") {
+                        REQUIRE(static_cast<const void *>(next.get()) == address);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+SCENARIO("promise chains can be allocated from a pool", "[juro]") {
+    GIVEN("a pool allocator and a chain built with it") {
+        juro::pool_allocator<int> allocator;
+
+        const auto run = [&] {
+            auto promise = juro::make_pending<int>(std::allocator_arg, allocator);
+            auto chained = promise
+                ->then(std::allocator_arg, allocator, [] (int value) { return value + 1; })
+                ->then_move(std::allocator_arg, allocator, [] (int &&value) { return value * 2; })
+                ->rescue(std::allocator_arg, allocator, [] (auto &) { return 0; })
+                ->finally(std::allocator_arg, allocator, [] (auto &) {  });
+            auto piped = juro::make_resolved(std::allocator_arg, allocator, 1)
+                ->then(std::allocator_arg, allocator, [&] (int value) {
+                    return juro::make_resolved(std::allocator_arg, allocator, value);
+                });
+            promise->resolve(20);
+            return chained->is_resolved() && piped->is_resolved();
+        };
+
+        WHEN("the chain is run once the pool is warmed up") {
+            REQUIRE(run());
+            REQUIRE(run());
+
+            const auto before = global_allocations;
+            const bool settled = run();
+            const auto allocated = global_allocations - before;
+
+            THEN("it must settle without allocating from the global heap") {
+                REQUIRE(settled);
+                REQUIRE(allocated == 0);
+            }
+        }
+    }
+}
+
+
+SCENARIO("chaining on a settled promise settles the chained promise directly", "[juro]") {
+    GIVEN("a resolved promise") {
+        auto promise = juro::make_resolved(10);
+
+        WHEN("a resolve handler that returns a value is attached") {
+            auto next = promise->then([] (int value) { return value * 2; });
+
+            THEN("the chained promise must be already resolved") {
+                REQUIRE(next->is_resolved());
+                REQUIRE(next->get_value() == 20);
+            }
+
+            THEN("no settle handler must have been stored") {
+                REQUIRE_FALSE(promise->has_handler());
+            }
+        }
+
+        WHEN("a resolve handler that returns nothing is attached") {
+            int resolved_value = 0;
+            auto next = promise->then([&] (int value) { resolved_value = value; });
+
+            THEN("the chained void promise must be already resolved") {
+                REQUIRE(resolved_value == 10);
+                REQUIRE(next->is_resolved());
+                REQUIRE(next->holds_value<void_type>());
+            }
+        }
+
+        WHEN("a resolve handler that throws is attached") {
+            auto result = attempt([&] {
+                return promise->then([] (int) -> int { throw "Thrown"s; });
+            });
+
+            THEN("the rejection must be thrown as unhandled") {
+                REQUIRE(result.holds_error<juro::promise_error>());
+                REQUIRE(result.get_error<juro::promise_error>().what() ==
+                    "Unhandled promise rejection"s);
+            }
+        }
+
+        WHEN("a resolve handler that returns a promise is attached") {
+            auto inner = juro::make_pending<std::string>();
+            auto next = promise->then([&] (int) { return inner; });
+
+            THEN("the chained promise must follow the returned promise") {
+                REQUIRE(next->is_pending());
+                inner->resolve("Resolved"s);
+                REQUIRE(next->is_resolved());
+                REQUIRE(next->get_value() == "Resolved"s);
+            }
+        }
+    }
+
+    GIVEN("a rejected promise") {
+        auto promise = juro::make_rejected<int>("Rejected"s);
+
+        WHEN("only a resolve handler is attached") {
+            auto result = attempt([&] {
+                return promise->then([] (int value) { return value; });
+            });
+
+            THEN("the rejection must be thrown as unhandled, as for a pending promise") {
+                REQUIRE(result.holds_error<juro::promise_error>());
+                REQUIRE(result.get_error<juro::promise_error>().what() ==
+                    "Unhandled promise rejection"s);
+            }
+        }
+
+        WHEN("a reject handler is attached") {
+            auto next = promise->rescue([] (std::exception_ptr &) { return -1; });
+
+            THEN("the chained promise must be already resolved") {
+                REQUIRE(next->is_resolved());
+                REQUIRE(next->get_value() == -1);
+            }
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file test/src/plumbing/benchmark.cpp
+ * @brief Benchmarks for plumbing; hidden from regular test runs, execute with
+ * `iara-test "[benchmark]"`
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <plumbing/framing.hpp>
+#include <plumbing/fused.hpp>
+
+namespace {
+
+constexpr std::size_t element_count = 4096;
+
+/**
+ * @brief A sink that adds up every element it consumes
+ */
+struct summer : public plumbing::sink<int> {
+    long total = 0;
+
+    using plumbing::sink<int>::consume;
+
+    void consume(const int &value) override { total += value; }
+
+    void consume(plumbing::span<const int> chunk) override {
+        for(const int &value : chunk) total += value;
+    }
+};
+
+/**
+ * @brief A sink that adds up the lengths of the frames it consumes
+ */
+struct frame_counter : public plumbing::sink<plumbing::frame> {
+    std::size_t total = 0;
+
+    using plumbing::sink<plumbing::frame>::consume;
+
+    void consume(const plumbing::frame &frame) override { total += frame.size(); }
+
+    void consume(plumbing::span<const plumbing::frame> chunk) override {
+        for(const auto &frame : chunk) total += frame.size();
+    }
+};
+
+} /* anonymous namespace */
+
+TEST_CASE("fused and dynamic pipelines", "[.][benchmark][plumbing]") {
+    std::vector<int> input(element_count);
+    std::iota(input.begin(), input.end(), 0);
+
+    const auto add_one = [] (int value) { return value + 1; };
+
+    plumbing::source<int> dynamic_source;
+    plumbing::transform<int, int> stage_1 { add_one }, stage_2 { add_one }, stage_3 { add_one }, stage_4 { add_one };
+    summer dynamic_sink;
+    dynamic_source >> stage_1 >> stage_2 >> stage_3 >> stage_4 >> dynamic_sink;
+
+    plumbing::source<int> fused_source;
+    auto fused_stage = plumbing::fuse<int>(
+        plumbing::map(add_one) >> plumbing::map(add_one) >>
+        plumbing::map(add_one) >> plumbing::map(add_one)
+    );
+    summer fused_sink;
+    fused_source >> fused_stage >> fused_sink;
+
+    BENCHMARK("4 dynamic stages, element by element") {
+        for(const int &value : input) dynamic_source.produce(value);
+        return dynamic_sink.total;
+    };
+
+    BENCHMARK("4 dynamic stages, one chunk") {
+        dynamic_source.produce(plumbing::span<const int> { input });
+        return dynamic_sink.total;
+    };
+
+    BENCHMARK("4 fused stages, element by element") {
+        for(const int &value : input) fused_source.produce(value);
+        return fused_sink.total;
+    };
+
+    BENCHMARK("4 fused stages, one chunk") {
+        fused_source.produce(plumbing::span<const int> { input });
+        return fused_sink.total;
+    };
+}
+
+TEST_CASE("delimited framing", "[.][benchmark][plumbing]") {
+    std::vector<std::uint8_t> input(1 << 16, 'x');
+    for(std::size_t i = 63; i < input.size(); i += 64) input[i] = '\n';
+
+    plumbing::source<std::uint8_t> source;
+    plumbing::delimited_framer framer;
+    frame_counter sink;
+    source >> framer >> sink;
+
+    BENCHMARK("64 KiB of lines, byte by byte") {
+        for(const auto &byte : input) source.produce(byte);
+        return sink.total;
+    };
+
+    BENCHMARK("64 KiB of lines, one chunk") {
+        source.produce(plumbing::span<const std::uint8_t> { input });
+        return sink.total;
+    };
+}
@@ -0,0 +1,1705 @@
+/**
+ * @file test/src/plumbing/test.cpp
+ * @brief Plumbing test routines
+ * @author André Medeiros
+ * @date 16/10/26
+ * @copyright 2026 (C) André Medeiros
+**/
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fugax/event-loop.hpp>
+#include <plumbing/async.hpp>
+#include <plumbing/descriptor.hpp>
+#include <plumbing/duplex.hpp>
+#include <plumbing/file.hpp>
+#include <plumbing/framing.hpp>
+#include <plumbing/fused.hpp>
+#include <plumbing/parallel-map.hpp>
+#include <plumbing/window.hpp>
+
+using namespace std::string_literals;
+
+namespace {
+
+/**
+ * @brief A sink that records the chunks it receives
+ */
+template<class T>
+struct chunk_recorder : public plumbing::sink<T> {
+    std::vector<std::vector<T>> chunks;
+
+    using plumbing::sink<T>::consume;
+
+    void consume(plumbing::span<const T> chunk) override {
+        chunks.emplace_back(chunk.begin(), chunk.end());
+    }
+};
+
+/**
+ * @brief A sink that only knows how to consume single elements
+ */
+template<class T>
+struct element_recorder : public plumbing::sink<T> {
+    std::vector<T> elements;
+
+    using plumbing::sink<T>::consume;
+
+    void consume(const T &element) override {
+        elements.push_back(element);
+    }
+};
+
+/**
+ * @brief A sink that can be paused and resumed at will
+ */
+template<class T, template<class> class T_recorder = element_recorder>
+struct valve : public T_recorder<T> {
+    using plumbing::flow_control::pause;
+    using plumbing::flow_control::resume;
+};
+
+/**
+ * @brief A sink that pulls elements by requesting credit
+ */
+template<class T>
+struct puller : public plumbing::active_sink<T> {
+    std::vector<T> elements;
+
+    using plumbing::active_sink<T>::consume;
+
+    void consume(const T &element) override {
+        elements.push_back(element);
+    }
+};
+
+/**
+ * @brief A buffered sink whose credit is set or granted from outside
+ */
+template<class T>
+struct credited : public plumbing::buffered_sink<T> {
+    std::vector<T> elements;
+
+    using plumbing::buffered_sink<T>::buffered_sink;
+    using plumbing::buffered_sink<T>::next;
+    using plumbing::buffered_sink<T>::grant;
+
+    void requested_data(const T &element) override {
+        elements.push_back(element);
+    }
+};
+
+/**
+ * @brief An element that counts how many times it has been copied
+ */
+struct tracked {
+    static inline int copies = 0;
+
+    int value = 0;
+
+    tracked(int value = 0) : value(value) {  }
+    tracked(const tracked &other) : value(other.value) { copies++; }
+    tracked(tracked &&) noexcept = default;
+    tracked &operator=(const tracked &other) { value = other.value; copies++; return *this; }
+    tracked &operator=(tracked &&) noexcept = default;
+};
+
+/**
+ * @brief A sink that keeps the elements it consumes, moving them when it can
+ */
+template<class T>
+struct keeper : public plumbing::sink<T> {
+    std::vector<T> elements;
+
+    using plumbing::sink<T>::consume;
+
+    void consume(const T &element) override {
+        if constexpr(std::is_copy_constructible_v<T>) {
+            elements.push_back(element);
+        }
+    }
+
+    void consume(T &&element) override {
+        elements.push_back(std::move(element));
+    }
+
+    void consume_owned(plumbing::span<T> chunk) override {
+        for(T &element : chunk) {
+            elements.push_back(std::move(element));
+        }
+    }
+};
+
+/**
+ * @brief A sink that records the frames it receives, and where they were
+ */
+struct frame_recorder : public plumbing::sink<plumbing::frame> {
+    std::vector<std::string> frames;
+    std::vector<const std::uint8_t *> addresses;
+    std::size_t chunks = 0;
+
+    using plumbing::sink<plumbing::frame>::consume;
+
+    void consume(plumbing::span<const plumbing::frame> chunk) override {
+        chunks++;
+        for(const auto &frame : chunk) {
+            frames.emplace_back(frame.begin(), frame.end());
+            addresses.push_back(frame.data());
+        }
+    }
+};
+
+/**
+ * @brief Views the bytes of a string
+ */
+plumbing::span<const std::uint8_t> bytes(const std::string &text) {
+    return { reinterpret_cast<const std::uint8_t *>(text.data()), text.size() };
+}
+
+/**
+ * @brief Processes a loop until a condition holds, or gives up after a while
+ */
+template<class T_condition>
+bool process_until(fugax::event_loop &loop, T_condition &&condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 10 };
+    while(!condition()) {
+        if(std::chrono::steady_clock::now() > deadline) return false;
+        loop.process(0);
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+} /* anonymous namespace */
+
+SCENARIO("a span views contiguous elements", "[plumbing]") {
+    GIVEN("a vector") {
+        std::vector<int> values { 1, 2, 3, 4, 5 };
+
+        WHEN("a span of it is created") {
+            plumbing::span<const int> view { values };
+
+            THEN("it must view all of its elements") {
+                REQUIRE(view.data() == values.data());
+                REQUIRE(view.size() == 5);
+                REQUIRE(view.front() == 1);
+                REQUIRE(view.back() == 5);
+            }
+
+            THEN("it can be narrowed") {
+                REQUIRE(std::vector<int>(view.first_n(2).begin(), view.first_n(2).end()) == std::vector<int> { 1, 2 });
+                REQUIRE(std::vector<int>(view.last_n(2).begin(), view.last_n(2).end()) == std::vector<int> { 4, 5 });
+                REQUIRE(view.subspan(1, 3)[0] == 2);
+                REQUIRE(view.subspan(4).size() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("sources emit chunks of elements", "[plumbing]") {
+    GIVEN("a source piped to a chunk-aware sink and to an element sink") {
+        plumbing::source<int> source;
+        chunk_recorder<int> chunks;
+        element_recorder<int> elements;
+        source >> chunks;
+        source >> elements;
+
+        WHEN("a chunk is produced") {
+            const int values[] { 1, 2, 3 };
+            source.produce(plumbing::span<const int> { values });
+
+            THEN("the chunk-aware sink must have received it whole") {
+                REQUIRE(chunks.chunks == std::vector<std::vector<int>> { { 1, 2, 3 } });
+            }
+
+            THEN("the element sink must have received each element") {
+                REQUIRE(elements.elements == std::vector<int> { 1, 2, 3 });
+            }
+        }
+
+        WHEN("single elements are produced") {
+            source.produce(1);
+            source.produce(2);
+
+            THEN("each must have been delivered as a one-element chunk") {
+                REQUIRE(chunks.chunks == std::vector<std::vector<int>> { { 1 }, { 2 } });
+                REQUIRE(elements.elements == std::vector<int> { 1, 2 });
+            }
+        }
+
+        WHEN("a contiguous collection is produced") {
+            source.produce(std::vector<int> { 4, 5, 6 });
+
+            THEN("it must have been delivered as a single chunk") {
+                REQUIRE(chunks.chunks == std::vector<std::vector<int>> { { 4, 5, 6 } });
+            }
+        }
+
+        WHEN("a non-contiguous collection is produced") {
+            source.produce(std::list<int> { 7, 8 });
+
+            THEN("its elements must have been delivered one by one") {
+                REQUIRE(chunks.chunks == std::vector<std::vector<int>> { { 7 }, { 8 } });
+            }
+        }
+
+        WHEN("an empty chunk is produced") {
+            source.produce(plumbing::span<const int> {  });
+
+            THEN("nothing must have been delivered") {
+                REQUIRE(chunks.chunks.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("splitters emit their input as a single chunk", "[plumbing]") {
+    GIVEN("a string splitter between a string source and a byte sink") {
+        plumbing::source<std::string> source;
+        plumbing::string_splitter splitter;
+        chunk_recorder<std::uint8_t> bytes;
+        source >> splitter >> bytes;
+
+        WHEN("strings are produced") {
+            source.produce("abc"s);
+            source.produce("de"s);
+
+            THEN("each must have reached the sink as one chunk of bytes") {
+                REQUIRE(bytes.chunks == std::vector<std::vector<std::uint8_t>> {
+                    { 'a', 'b', 'c' }, { 'd', 'e' }
+                });
+            }
+        }
+    }
+
+    GIVEN("a vector splitter between a vector source and an element sink") {
+        plumbing::source<std::vector<int>> source;
+        plumbing::splitter<int> splitter;
+        element_recorder<int> elements;
+        source >> splitter >> elements;
+
+        WHEN("a vector is produced") {
+            source.produce(std::vector<int> { 1, 2, 3 });
+
+            THEN("its elements must have reached the element sink") {
+                REQUIRE(elements.elements == std::vector<int> { 1, 2, 3 });
+            }
+        }
+    }
+}
+
+SCENARIO("transforms emit each chunk as a single chunk", "[plumbing]") {
+    GIVEN("a transform stage between a source and a sink") {
+        plumbing::source<int> source;
+        plumbing::transform<int, std::string> stage { [] (int value) { return std::to_string(value); } };
+        chunk_recorder<std::string> sink;
+        source >> stage >> sink;
+
+        WHEN("a chunk is produced") {
+            source.produce(std::vector<int> { 1, 2, 3 });
+
+            THEN("the transformed elements must have been emitted as one chunk") {
+                REQUIRE(sink.chunks == std::vector<std::vector<std::string>> { { "1"s, "2"s, "3"s } });
+            }
+        }
+
+        WHEN("a chunk is handed over") {
+            std::vector<int> values { 4, 5 };
+            source.produce_owned(plumbing::span<int> { values });
+
+            THEN("the transformed elements must have been emitted as one chunk") {
+                REQUIRE(sink.chunks == std::vector<std::vector<std::string>> { { "4"s, "5"s } });
+            }
+        }
+    }
+}
+
+SCENARIO("stages apply backpressure to their sources", "[plumbing]") {
+    GIVEN("a source piped through a transform to a sink that can be paused") {
+        plumbing::source<int> source;
+        plumbing::transform<int, int> identity { [] (int value) { return value; } };
+        valve<int> sink;
+        source >> identity >> sink;
+
+        THEN("the source must be writable") {
+            REQUIRE(source.writable());
+        }
+
+        WHEN("the sink pauses") {
+            sink.pause();
+
+            THEN("the pause must have propagated to the source") {
+                REQUIRE(identity.paused());
+                REQUIRE_FALSE(source.writable());
+            }
+
+            AND_WHEN("the sink resumes") {
+                sink.resume();
+
+                THEN("the source must be writable again") {
+                    REQUIRE_FALSE(identity.paused());
+                    REQUIRE(source.writable());
+                }
+            }
+        }
+    }
+
+    GIVEN("a bounded buffer between a source and a sink that can be paused") {
+        plumbing::source<int> source;
+        plumbing::buffer<int> buffer { plumbing::watermarks { 1, 3, 4 } };
+        valve<int> sink;
+        source >> buffer >> sink;
+
+        WHEN("elements are produced while the sink is not paused") {
+            source.produce(std::vector<int> { 1, 2 });
+
+            THEN("they must have passed through") {
+                REQUIRE(sink.elements == std::vector<int> { 1, 2 });
+                REQUIRE(buffer.buffered() == 0);
+            }
+        }
+
+        WHEN("the sink pauses") {
+            sink.pause();
+
+            THEN("the buffer must absorb the pause") {
+                REQUIRE(source.writable());
+            }
+
+            AND_WHEN("elements are produced up to the high watermark") {
+                source.produce(std::vector<int> { 1, 2, 3 });
+
+                THEN("they must have been buffered and the source paused") {
+                    REQUIRE(sink.elements.empty());
+                    REQUIRE(buffer.buffered() == 3);
+                    REQUIRE_FALSE(source.writable());
+                }
+
+                AND_WHEN("more elements than the capacity are produced") {
+                    source.produce(4);
+
+                    THEN("the excess must be refused") {
+                        REQUIRE_THROWS_AS(source.produce(5), std::length_error);
+                        REQUIRE(buffer.buffered() == 4);
+                    }
+                }
+
+                AND_WHEN("the sink resumes") {
+                    sink.resume();
+
+                    THEN("the buffered elements must have been delivered in order") {
+                        REQUIRE(sink.elements == std::vector<int> { 1, 2, 3 });
+                        REQUIRE(buffer.buffered() == 0);
+                        REQUIRE(source.writable());
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a source piped to a sink that can be paused") {
+        plumbing::source<int> source;
+        auto sink = std::make_unique<valve<int>>();
+        source >> *sink;
+        sink->pause();
+
+        WHEN("the paused sink is destroyed") {
+            sink.reset();
+
+            THEN("the source must be writable again") {
+                REQUIRE(source.writable());
+            }
+        }
+
+        WHEN("the paused sink is piped from another source") {
+            plumbing::source<int> other;
+            other >> *sink;
+
+            THEN("only the other source must count it as paused") {
+                REQUIRE(source.writable());
+                REQUIRE_FALSE(other.writable());
+            }
+
+            AND_WHEN("the first source produces elements") {
+                source.produce(1);
+
+                THEN("the sink must no longer receive them") {
+                    REQUIRE(sink->elements.empty());
+                }
+            }
+        }
+    }
+
+    GIVEN("a source piped to two sinks, one of which goes away") {
+        plumbing::source<tracked> source;
+        keeper<tracked> sink;
+        auto other = std::make_unique<keeper<tracked>>();
+        source >> sink;
+        source >> *other;
+        other.reset();
+
+        WHEN("elements are handed over") {
+            std::vector<tracked> values { 1, 2 };
+            tracked::copies = 0;
+            source.produce_owned(plumbing::span<tracked> { values });
+
+            THEN("the remaining sink must have moved them") {
+                REQUIRE(sink.elements.size() == 2);
+                REQUIRE(tracked::copies == 0);
+            }
+        }
+    }
+
+    GIVEN("a byte buffer with the default watermarks before a sink that can be paused") {
+        plumbing::source<std::uint8_t> source;
+        plumbing::buffer<std::uint8_t> buffer;
+        valve<std::uint8_t, chunk_recorder> sink;
+        source >> buffer >> sink;
+        const std::vector<std::uint8_t> chunk(1000, 7);
+
+        WHEN("a chunk is produced while the sink is not paused") {
+            source.produce(plumbing::span<const std::uint8_t> { chunk });
+
+            THEN("it must have passed through whole") {
+                REQUIRE(sink.chunks == std::vector<std::vector<std::uint8_t>> { chunk });
+            }
+        }
+
+        WHEN("the sink pauses") {
+            sink.pause();
+
+            THEN("the source must only have room for the capacity of the buffer") {
+                REQUIRE(source.downstream_room() == 256);
+            }
+
+            AND_WHEN("a chunk larger than the capacity is produced") {
+                THEN("it must have been buffered up to the capacity and the rest refused") {
+                    REQUIRE_THROWS_AS(source.produce(plumbing::span<const std::uint8_t> { chunk }), std::length_error);
+                    REQUIRE(buffer.buffered() == 256);
+                    REQUIRE(source.downstream_room() == 0);
+                    REQUIRE_FALSE(source.writable());
+                }
+            }
+
+            AND_WHEN("a chunk is produced in pieces no larger than the room") {
+                plumbing::span<const std::uint8_t> rest { chunk };
+                while(source.writable()) {
+                    const auto piece = std::min(rest.size(), source.downstream_room());
+                    source.produce(rest.first_n(piece));
+                    rest = rest.subspan(piece);
+                }
+
+                THEN("the buffer must have taken the first piece and paused the source") {
+                    REQUIRE(buffer.buffered() == 256);
+                    REQUIRE(rest.size() == 744);
+                }
+
+                AND_WHEN("the sink resumes") {
+                    sink.resume();
+
+                    THEN("the buffered elements must have been delivered as a single chunk") {
+                        REQUIRE(sink.chunks == std::vector<std::vector<std::uint8_t>> {
+                            std::vector<std::uint8_t>(256, 7)
+                        });
+                        REQUIRE(buffer.buffered() == 0);
+                        REQUIRE(source.writable());
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a bounded buffer piped to an active sink") {
+        plumbing::source<int> source;
+        plumbing::buffer<int> buffer { plumbing::watermarks { 0, 2, 4 } };
+        puller<int> sink;
+        source >> buffer >> sink;
+
+        WHEN("elements are produced without credit") {
+            source.produce(std::vector<int> { 1, 2 });
+
+            THEN("they must have been buffered and the source paused") {
+                REQUIRE(sink.elements.empty());
+                REQUIRE_FALSE(source.writable());
+            }
+
+            AND_WHEN("the sink requests credit for one element") {
+                sink.request_data(1);
+
+                THEN("only one element must have been delivered") {
+                    REQUIRE(sink.elements == std::vector<int> { 1 });
+                    REQUIRE_FALSE(source.writable());
+                }
+            }
+
+            AND_WHEN("the sink requests more credit than there are elements") {
+                sink.request_data(3);
+                source.produce(3);
+
+                THEN("the remaining credit must pass new elements through") {
+                    REQUIRE(sink.elements == std::vector<int> { 1, 2, 3 });
+                    REQUIRE(buffer.credit() == 0);
+                    REQUIRE(source.writable());
+                }
+            }
+        }
+
+        WHEN("a chunk larger than the credit is produced") {
+            sink.request_data(1);
+            const std::vector<int> chunk { 1, 2, 3 };
+            source.produce(plumbing::span<const int> { chunk });
+
+            THEN("only the credited part must pass through, and the rest be buffered") {
+                REQUIRE(sink.elements == std::vector<int> { 1 });
+                REQUIRE(buffer.buffered() == 2);
+                REQUIRE(buffer.credit() == 0);
+                REQUIRE_FALSE(source.writable());
+            }
+        }
+    }
+
+    GIVEN("a large buffer chained to a small buffer piped to an active sink") {
+        plumbing::source<int> source;
+        plumbing::buffer<int> large { plumbing::watermarks { 2, 80, 100 } };
+        plumbing::buffer<int> small { plumbing::watermarks { 2, 8, 10 } };
+        puller<int> sink;
+        source >> large >> small >> sink;
+
+        std::vector<int> elements(50);
+        for(int i = 0; i < 50; i++) elements[i] = i;
+
+        WHEN("more elements are produced than the small buffer holds") {
+            source.produce(elements);
+
+            THEN("the small buffer must have been filled and the rest held by the large one") {
+                REQUIRE(small.buffered() == 10);
+                REQUIRE(large.buffered() == 40);
+            }
+
+            AND_WHEN("the sink pulls a few elements at a time") {
+                sink.request_data(7);
+                sink.request_data(1);
+
+                THEN("the large buffer must have refilled the small one without overflowing it") {
+                    REQUIRE(sink.elements.size() == 8);
+                    REQUIRE(small.buffered() == 10);
+                    REQUIRE(large.buffered() == 32);
+                }
+
+                AND_WHEN("the sink pulls every element") {
+                    sink.request_data(1000);
+
+                    THEN("every element must have reached it in order") {
+                        REQUIRE(sink.elements == elements);
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a buffered sink holding some elements") {
+        plumbing::source<int> source;
+        credited<int> sink;
+        source >> sink;
+        source.produce(std::vector<int> { 1, 2, 3, 4, 5 });
+
+        WHEN("credit is set twice") {
+            sink.next(0);
+            sink.next(1);
+            sink.next(1);
+
+            THEN("each call must have replaced the credit") {
+                REQUIRE(sink.elements == std::vector<int> { 1, 2 });
+                REQUIRE(sink.credit() == 0);
+            }
+        }
+
+        WHEN("credit is granted twice while more elements are buffered") {
+            sink.grant(2);
+            sink.grant(4);
+
+            THEN("the credits must have accumulated") {
+                REQUIRE(sink.elements == std::vector<int> { 1, 2, 3, 4, 5 });
+                REQUIRE(sink.credit() == 1);
+            }
+        }
+    }
+
+    GIVEN("inconsistent watermarks") {
+        THEN("a buffer must not be constructed") {
+            REQUIRE_THROWS_AS(plumbing::buffer<int>(plumbing::watermarks { 4, 2, 8 }), std::invalid_argument);
+        }
+    }
+}
+
+SCENARIO("chains of transformations are fused into a single stage", "[plumbing]") {
+    GIVEN("a chain of transformations known at compile time") {
+        constexpr auto chain =
+            plumbing::map([] (int value) { return value + 1; }) >>
+            plumbing::map([] (int value) { return value * 2; });
+
+        THEN("it must be usable in constant expressions") {
+            STATIC_REQUIRE(chain(1) == 4);
+        }
+
+        AND_GIVEN("a stage fusing it with a conversion, between a source and a sink") {
+            plumbing::source<int> source;
+            auto stage = plumbing::fuse<int>(
+                chain >> plumbing::map([] (int value) { return std::to_string(value); })
+            );
+            chunk_recorder<std::string> sink;
+            source >> stage >> sink;
+
+            WHEN("a chunk is produced") {
+                source.produce(std::vector<int> { 1, 2, 3 });
+
+                THEN("the transformed elements must have been emitted as one chunk") {
+                    REQUIRE(sink.chunks == std::vector<std::vector<std::string>> { { "4"s, "6"s, "8"s } });
+                }
+            }
+
+            WHEN("an element is produced") {
+                source.produce(0);
+
+                THEN("it must have been transformed by the whole chain") {
+                    REQUIRE(sink.chunks == std::vector<std::vector<std::string>> { { "2"s } });
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("elements can be moved through a pipeline", "[plumbing]") {
+    GIVEN("a pipeline of move-only elements") {
+        using element = std::unique_ptr<int>;
+
+        plumbing::source<element> source;
+        plumbing::transform<element, element> doubler { [] (element value) {
+            *value *= 2;
+            return value;
+        } };
+        plumbing::buffer<element> buffer;
+        keeper<element> sink;
+        source >> doubler >> buffer >> sink;
+
+        WHEN("an element is handed over") {
+            auto value = std::make_unique<int>(21);
+            const int *address = value.get();
+            source.produce(std::move(value));
+
+            THEN("the same object must have reached the sink") {
+                REQUIRE(sink.elements.size() == 1);
+                REQUIRE(sink.elements[0].get() == address);
+                REQUIRE(*sink.elements[0] == 42);
+            }
+        }
+
+        WHEN("a chunk is handed over") {
+            std::vector<element> values;
+            values.push_back(std::make_unique<int>(1));
+            values.push_back(std::make_unique<int>(2));
+            source.produce_owned(plumbing::span<element> { values });
+
+            THEN("its elements must have been moved to the sink") {
+                REQUIRE(sink.elements.size() == 2);
+                REQUIRE(*sink.elements[0] == 2);
+                REQUIRE(*sink.elements[1] == 4);
+                REQUIRE(values[0] == nullptr);
+            }
+        }
+
+        WHEN("an element is only lent") {
+            const auto value = std::make_unique<int>(1);
+
+            THEN("the transform must refuse it") {
+                REQUIRE_THROWS_AS(source.produce(value), std::logic_error);
+            }
+        }
+    }
+
+    GIVEN("a linear pipeline of copyable elements") {
+        plumbing::source<tracked> source;
+        auto stage = plumbing::fuse<tracked>(plumbing::map([] (tracked value) {
+            value.value++;
+            return value;
+        }));
+        plumbing::buffer<tracked> buffer;
+        keeper<tracked> sink;
+        source >> stage >> buffer >> sink;
+
+        WHEN("elements are handed over") {
+            std::vector<tracked> values { 1, 2, 3 };
+            tracked::copies = 0;
+            source.produce_owned(plumbing::span<tracked> { values });
+            source.produce(tracked { 4 });
+
+            THEN("they must not have been copied") {
+                REQUIRE(sink.elements.size() == 4);
+                REQUIRE(sink.elements[3].value == 5);
+                REQUIRE(tracked::copies == 0);
+            }
+        }
+
+        AND_GIVEN("a second sink") {
+            keeper<tracked> other;
+            source >> other;
+
+            WHEN("an element is handed over") {
+                source.produce(tracked { 1 });
+
+                THEN("each sink must have received it") {
+                    REQUIRE(sink.elements.size() == 1);
+                    REQUIRE(other.elements.size() == 1);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("an asynchronous stage delivers elements in another event loop", "[plumbing]") {
+    GIVEN("an asynchronous stage between two loops") {
+        fugax::event_loop origin;
+        fugax::event_loop target;
+        plumbing::source<int> source;
+        plumbing::async<int> stage { origin, target, plumbing::watermarks { 1, 3, 4 } };
+        chunk_recorder<int> chunks;
+        source >> stage >> chunks;
+
+        WHEN("elements are produced") {
+            source.produce(1);
+            source.produce(2);
+
+            THEN("nothing must have been delivered yet") {
+                REQUIRE(chunks.chunks.empty());
+                REQUIRE(stage.queued() == 2);
+            }
+
+            AND_WHEN("the target loop is processed") {
+                target.process(0);
+
+                THEN("they must have been delivered in order as a single chunk") {
+                    REQUIRE(chunks.chunks == std::vector<std::vector<int>> { { 1, 2 } });
+                    REQUIRE(stage.queued() == 0);
+                }
+            }
+        }
+
+        WHEN("elements are produced up to the high watermark") {
+            source.produce(std::vector<int> { 1, 2, 3 });
+
+            THEN("the source must have been paused") {
+                REQUIRE_FALSE(source.writable());
+            }
+
+            THEN("elements past the capacity must be refused") {
+                source.produce(4);
+                REQUIRE_THROWS_AS(source.produce(5), std::length_error);
+            }
+
+            AND_WHEN("the target loop drains the stage") {
+                target.process(0);
+
+                THEN("the source must only resume in the origin loop") {
+                    REQUIRE_FALSE(source.writable());
+                    origin.process(0);
+                    REQUIRE(source.writable());
+                }
+            }
+        }
+    }
+
+    GIVEN("an asynchronous stage whose capacity is not a power of two") {
+        fugax::event_loop origin;
+        fugax::event_loop target;
+        plumbing::source<int> source;
+        plumbing::async<int> stage { origin, target, plumbing::watermarks { 50, 100, 100 } };
+        chunk_recorder<int> chunks;
+        source >> stage >> chunks;
+
+        WHEN("elements are produced up to the capacity") {
+            for(int i = 0; i < 100; i++) {
+                source.produce(i);
+            }
+
+            THEN("elements past the capacity must be refused, even if the queue has room") {
+                REQUIRE_THROWS_AS(source.produce(100), std::length_error);
+                REQUIRE(stage.queued() == 100);
+            }
+        }
+    }
+
+    GIVEN("an asynchronous stage whose downstream can be paused") {
+        fugax::event_loop origin;
+        fugax::event_loop target;
+        plumbing::source<int> source;
+        plumbing::async<int> stage { origin, target };
+        valve<int> sink;
+        source >> stage >> sink;
+
+        WHEN("the downstream pauses") {
+            sink.pause();
+            source.produce(1);
+            target.process(0);
+
+            THEN("the stage must hold its elements") {
+                REQUIRE(sink.elements.empty());
+                REQUIRE(stage.queued() == 1);
+            }
+
+            AND_WHEN("the downstream resumes") {
+                sink.resume();
+                target.process(0);
+
+                THEN("the held elements must have been delivered") {
+                    REQUIRE(sink.elements == std::vector<int> { 1 });
+                }
+            }
+        }
+    }
+
+    GIVEN("an asynchronous stage whose downstream takes two elements at a time and fails once") {
+        struct faulty : public chunk_recorder<int> {
+            bool failed = false;
+
+            std::size_t room() const noexcept override { return 2; }
+
+            void consume(plumbing::span<const int> chunk) override {
+                if(!std::exchange(failed, true)) {
+                    throw std::runtime_error { "Delivery failed" };
+                }
+                chunk_recorder<int>::consume(chunk);
+            }
+        };
+
+        fugax::event_loop origin;
+        fugax::event_loop target;
+        plumbing::source<int> source;
+        plumbing::async<int> stage { origin, target };
+        faulty sink;
+        source >> stage >> sink;
+
+        WHEN("elements are produced and delivering the first chunk throws") {
+            source.produce(std::vector<int> { 1, 2, 3, 4, 5 });
+            REQUIRE_THROWS_AS(target.process(0), std::runtime_error);
+
+            THEN("the undelivered elements must still be accounted for") {
+                REQUIRE(stage.queued() == 3);
+            }
+
+            AND_WHEN("the target loop is processed again") {
+                target.process(0);
+
+                THEN("the rest of the batch must have been delivered in room-sized chunks") {
+                    REQUIRE(sink.chunks == std::vector<std::vector<int>> { { 3, 4 }, { 5 } });
+                    REQUIRE(stage.queued() == 0);
+                }
+            }
+        }
+    }
+
+    GIVEN("an asynchronous stage of move-only elements") {
+        fugax::event_loop origin;
+        fugax::event_loop target;
+        plumbing::source<std::unique_ptr<int>> source;
+        plumbing::async<std::unique_ptr<int>> stage { origin, target };
+        keeper<std::unique_ptr<int>> sink;
+        source >> stage >> sink;
+
+        WHEN("an element is handed over") {
+            source.produce(std::make_unique<int>(7));
+            target.process(0);
+
+            THEN("it must have been moved to the sink") {
+                REQUIRE(sink.elements.size() == 1);
+                REQUIRE(*sink.elements[0] == 7);
+            }
+        }
+    }
+
+    GIVEN("an asynchronous stage whose target loop runs in another thread") {
+        constexpr int element_count = 10000;
+
+        fugax::event_loop origin;
+        fugax::event_loop target;
+        plumbing::source<int> source;
+        plumbing::async<int> stage { origin, target, plumbing::watermarks { 16, 64, 128 } };
+        keeper<int> sink;
+        source >> stage >> sink;
+
+        std::atomic<bool> done = false;
+        std::thread consumer { [&] {
+            while(!done.load()) {
+                target.process(0);
+                std::this_thread::yield();
+            }
+            target.process(0);
+        } };
+
+        WHEN("elements are produced honouring backpressure") {
+            for(int i = 0; i < element_count; i++) {
+                while(!source.writable()) {
+                    origin.process(0);
+                    std::this_thread::yield();
+                }
+                source.produce(i);
+            }
+            done.store(true);
+            consumer.join();
+
+            THEN("every element must have been delivered in order") {
+                REQUIRE(sink.elements.size() == element_count);
+                bool ordered = true;
+                for(int i = 0; i < element_count; i++) {
+                    ordered = ordered && sink.elements[i] == i;
+                }
+                REQUIRE(ordered);
+            }
+        }
+    }
+}
+
+SCENARIO("a parallel map delivers results in input order", "[plumbing]") {
+    GIVEN("a parallel map whose workers finish out of order") {
+        constexpr int element_count = 32;
+
+        fugax::event_loop loop;
+        plumbing::source<int> source;
+        plumbing::parallel_map<int, std::string> stage { loop, [] (int value) {
+            std::this_thread::sleep_for(std::chrono::microseconds { (element_count - value) * 50 });
+            return std::to_string(value);
+        }, 4, element_count };
+        keeper<std::string> sink;
+        source >> stage >> sink;
+
+        WHEN("elements are produced") {
+            for(int i = 0; i < element_count; i++) source.produce(i);
+
+            THEN("the results must have been delivered in order") {
+                REQUIRE(process_until(loop, [&] { return sink.elements.size() == element_count; }));
+                bool ordered = true;
+                for(int i = 0; i < element_count; i++) {
+                    ordered = ordered && sink.elements[i] == std::to_string(i);
+                }
+                REQUIRE(ordered);
+                REQUIRE(stage.in_flight() == 0);
+            }
+        }
+    }
+
+    GIVEN("a parallel map with a small window and blocked workers") {
+        fugax::event_loop loop;
+        std::atomic<bool> released = false;
+        plumbing::source<int> source;
+        plumbing::parallel_map<int> stage { loop, [&] (int value) {
+            while(!released.load()) std::this_thread::yield();
+            return value * 10;
+        }, 2, 4 };
+        keeper<int> sink;
+        source >> stage >> sink;
+
+        WHEN("the window is filled") {
+            source.produce(std::vector<int> { 1, 2, 3, 4 });
+
+            THEN("the source must have been paused and further elements refused") {
+                const bool writable = source.writable();
+                bool refused = false;
+                try {
+                    source.produce(5);
+                } catch(const std::length_error &) {
+                    refused = true;
+                }
+                released.store(true);
+
+                REQUIRE_FALSE(writable);
+                REQUIRE(refused);
+            }
+
+            AND_WHEN("the workers are released") {
+                released.store(true);
+
+                THEN("the results must be delivered and the source resumed") {
+                    REQUIRE(process_until(loop, [&] { return sink.elements.size() == 4; }));
+                    REQUIRE(sink.elements == std::vector<int> { 10, 20, 30, 40 });
+                    REQUIRE(source.writable());
+                }
+            }
+        }
+    }
+
+    GIVEN("a parallel map piped to a small buffer and an active sink") {
+        constexpr int element_count = 16;
+
+        fugax::event_loop loop;
+        plumbing::source<int> source;
+        plumbing::parallel_map<int> stage { loop, [] (int value) { return value; }, 2, element_count };
+        plumbing::buffer<int> buffer { plumbing::watermarks { 2, 8, 10 } };
+        puller<int> sink;
+        source >> stage >> buffer >> sink;
+
+        std::vector<int> elements(element_count);
+        for(int i = 0; i < element_count; i++) elements[i] = i;
+
+        WHEN("more elements are mapped than the buffer holds") {
+            source.produce(elements);
+
+            THEN("the buffer must be filled and the other results kept") {
+                REQUIRE(process_until(loop, [&] { return buffer.buffered() == 10; }));
+                loop.process(0);
+                REQUIRE(buffer.buffered() == 10);
+                REQUIRE(stage.in_flight() == element_count - 10);
+            }
+
+            AND_WHEN("the sink pulls every element") {
+                REQUIRE(process_until(loop, [&] { return buffer.buffered() == 10; }));
+                sink.request_data(1000);
+
+                THEN("every result must reach it in order") {
+                    REQUIRE(process_until(loop, [&] { return sink.elements.size() == element_count; }));
+                    REQUIRE(sink.elements == elements);
+                }
+            }
+        }
+    }
+
+    GIVEN("a parallel map whose function throws for some element") {
+        fugax::event_loop loop;
+        plumbing::source<int> source;
+        plumbing::parallel_map<int> stage { loop, [] (int value) {
+            if(value == 2) throw std::runtime_error { "bad element" };
+            return value;
+        }, 2, 8 };
+        keeper<int> sink;
+        source >> stage >> sink;
+
+        WHEN("elements are produced") {
+            source.produce(std::vector<int> { 1, 2, 3 });
+
+            THEN("the error must be rethrown from the loop in its place") {
+                bool thrown = false;
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 10 };
+                while(!(thrown && sink.elements.size() == 2) && std::chrono::steady_clock::now() < deadline) {
+                    try {
+                        loop.process(0);
+                    } catch(const std::runtime_error &) {
+                        REQUIRE(sink.elements == std::vector<int> { 1 });
+                        thrown = true;
+                    }
+                    std::this_thread::yield();
+                }
+
+                REQUIRE(thrown);
+                REQUIRE(sink.elements == std::vector<int> { 1, 3 });
+            }
+        }
+    }
+}
+
+SCENARIO("files can be read through a mapping and written through a buffer", "[plumbing]") {
+    GIVEN("a file written through a file sink") {
+        const auto path = (std::filesystem::temp_directory_path() / "plumbing-file-test.bin").string();
+        std::vector<std::uint8_t> contents(10000);
+        for(std::size_t i = 0; i < contents.size(); i++) {
+            contents[i] = static_cast<std::uint8_t>(i * 7);
+        }
+
+        {
+            plumbing::source<std::uint8_t> source;
+            plumbing::file_sink sink { path, 4096 };
+            source >> sink;
+
+            source.produce(plumbing::span<const std::uint8_t> { contents.data(), 100 });
+            source.produce(contents[100]);
+            source.produce(plumbing::span<const std::uint8_t> { contents.data() + 101, 5000 });
+            source.produce(plumbing::span<const std::uint8_t> { contents.data() + 5101, contents.size() - 5101 });
+            sink.flush();
+        }
+
+        WHEN("it is read through a mapped file source") {
+            plumbing::mapped_file_source source { path, 4096 };
+            chunk_recorder<std::uint8_t> sink;
+            source >> sink;
+
+            THEN("its contents must be the written bytes") {
+                REQUIRE(source.contents().size() == contents.size());
+                REQUIRE(std::equal(contents.begin(), contents.end(), source.contents().begin()));
+            }
+
+            AND_WHEN("it is pumped") {
+                const bool finished = source.pump();
+
+                THEN("it must have been emitted in chunks of at most the chunk size") {
+                    REQUIRE(finished);
+                    REQUIRE(source.remaining() == 0);
+                    REQUIRE(sink.chunks.size() == 3);
+                    REQUIRE(sink.chunks[0].size() == 4096);
+                    REQUIRE(sink.chunks[2].size() == contents.size() - 8192);
+
+                    std::vector<std::uint8_t> read;
+                    for(auto &chunk : sink.chunks) read.insert(read.end(), chunk.begin(), chunk.end());
+                    REQUIRE(read == contents);
+                }
+            }
+        }
+
+        WHEN("it is read by a paused sink") {
+            plumbing::mapped_file_source source { path, 4096 };
+            valve<std::uint8_t> sink;
+            source >> sink;
+            sink.pause();
+
+            THEN("pumping must emit nothing until the sink resumes") {
+                REQUIRE_FALSE(source.pump());
+                REQUIRE(source.remaining() == contents.size());
+                sink.resume();
+                REQUIRE(source.remaining() == 0);
+                REQUIRE(sink.elements == contents);
+                REQUIRE(source.pump());
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    GIVEN("a file sink whose file cannot grow past a size limit") {
+        const auto path = (std::filesystem::temp_directory_path() / "plumbing-file-limit-test.bin").string();
+        std::vector<std::uint8_t> contents(300);
+        for(std::size_t i = 0; i < contents.size(); i++) {
+            contents[i] = static_cast<std::uint8_t>(i);
+        }
+
+        // Writes past the limit are cut short, then fail with EFBIG
+        const auto previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+        ::rlimit previous_limit;
+        REQUIRE(::getrlimit(RLIMIT_FSIZE, &previous_limit) == 0);
+
+        {
+            plumbing::file_sink sink { path, 4096 };
+            sink.consume(plumbing::span<const std::uint8_t> { contents });
+
+            ::rlimit limit = previous_limit;
+            limit.rlim_cur = 100;
+            REQUIRE(::setrlimit(RLIMIT_FSIZE, &limit) == 0);
+
+            WHEN("flushing fails partway") {
+                const bool failed = [&] {
+                    try {
+                        sink.flush();
+                        return false;
+                    } catch(const std::system_error &) {
+                        return true;
+                    }
+                }();
+                REQUIRE(::setrlimit(RLIMIT_FSIZE, &previous_limit) == 0);
+
+                AND_WHEN("it is flushed again once the file can grow") {
+                    sink.flush();
+
+                    THEN("each byte must have been written exactly once") {
+                        REQUIRE(failed);
+                        std::ifstream file { path, std::ios::binary };
+                        const std::vector<std::uint8_t> written {
+                            std::istreambuf_iterator<char> { file },
+                            std::istreambuf_iterator<char> {  }
+                        };
+                        REQUIRE(written == contents);
+                    }
+                }
+            }
+
+            ::setrlimit(RLIMIT_FSIZE, &previous_limit);
+        }
+
+        std::signal(SIGXFSZ, previous_handler);
+        std::filesystem::remove(path);
+    }
+
+    GIVEN("a file that does not exist") {
+        THEN("it cannot be mapped") {
+            REQUIRE_THROWS_AS(plumbing::mapped_file_source("/nonexistent/plumbing-file"), std::system_error);
+        }
+    }
+}
+
+SCENARIO("descriptors are read and written without blocking", "[plumbing]") {
+    fugax::event_loop loop;
+    plumbing::poller events { loop };
+
+    GIVEN("a source reading from a pipe") {
+        int ends[2];
+        REQUIRE(::pipe(ends) == 0);
+
+        {
+            plumbing::descriptor_source source { events, ends[0], 16, 2 };
+            chunk_recorder<std::uint8_t> sink;
+            source >> sink;
+
+            bool closed = false;
+            auto listener = source.listen<plumbing::messages::descriptor::closed>([&] { closed = true; });
+
+            WHEN("bytes are written to the pipe") {
+                const std::string text = "the quick brown fox jumps over the lazy dog";
+                REQUIRE(::write(ends[1], text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+                loop.process(0);
+
+                THEN("they must be emitted in chunks of at most the buffer size") {
+                    std::string read;
+                    for(auto &chunk : sink.chunks) {
+                        REQUIRE(chunk.size() <= 16);
+                        read.append(chunk.begin(), chunk.end());
+                    }
+                    REQUIRE(read == text);
+                    REQUIRE_FALSE(source.closed());
+                }
+            }
+
+            WHEN("the other end is closed") {
+                ::close(ends[1]);
+                ends[1] = -1;
+                loop.process(0);
+
+                THEN("the source must notify that it has been closed") {
+                    REQUIRE(closed);
+                    REQUIRE(source.closed());
+                }
+            }
+
+            listener.cancel();
+        }
+
+        ::close(ends[0]);
+        if(ends[1] >= 0) ::close(ends[1]);
+    }
+
+    GIVEN("a source reading from a pipe into a paused sink") {
+        int ends[2];
+        REQUIRE(::pipe(ends) == 0);
+
+        {
+            plumbing::descriptor_source source { events, ends[0] };
+            valve<std::uint8_t> sink;
+            source >> sink;
+            sink.pause();
+
+            REQUIRE(::write(ends[1], "abc", 3) == 3);
+            loop.process(0);
+
+            THEN("nothing must be read until the sink resumes") {
+                REQUIRE(sink.elements.empty());
+                sink.resume();
+                loop.process(0);
+                REQUIRE(sink.elements == std::vector<std::uint8_t> { 'a', 'b', 'c' });
+            }
+        }
+
+        ::close(ends[0]);
+        ::close(ends[1]);
+    }
+
+    GIVEN("a source reading from a pipe into a buffer before a sink without credit") {
+        int ends[2];
+        REQUIRE(::pipe(ends) == 0);
+
+        {
+            plumbing::descriptor_source source { events, ends[0], 1024, 4 };
+            plumbing::buffer<std::uint8_t> buffer;
+            puller<std::uint8_t> sink;
+            source >> buffer >> sink;
+
+            std::vector<std::uint8_t> contents(4096);
+            for(std::size_t i = 0; i < contents.size(); i++) {
+                contents[i] = static_cast<std::uint8_t>(i * 7);
+            }
+            REQUIRE(::write(ends[1], contents.data(), contents.size()) == 4096);
+
+            WHEN("the loop processes the readable pipe") {
+                REQUIRE_NOTHROW(loop.process(0));
+
+                THEN("the buffer must have been filled up to its capacity and the source paused") {
+                    REQUIRE(buffer.buffered() == 256);
+                    REQUIRE_FALSE(source.writable());
+                }
+
+                AND_WHEN("the sink requests credit for everything") {
+                    sink.request_data(contents.size());
+                    loop.process(0);
+
+                    THEN("every byte must have been delivered, in order") {
+                        REQUIRE(sink.elements == contents);
+                    }
+                }
+            }
+        }
+
+        ::close(ends[0]);
+        ::close(ends[1]);
+    }
+
+    GIVEN("a sink writing into a small pipe") {
+        int ends[2];
+        REQUIRE(::pipe(ends) == 0);
+        ::fcntl(ends[1], F_SETPIPE_SZ, 4096);
+        const int capacity = ::fcntl(ends[1], F_GETPIPE_SZ);
+
+        {
+            plumbing::source<std::uint8_t> source;
+            plumbing::descriptor_sink sink { events, ends[1], { 1024, 4096, 1 << 20 } };
+            source >> sink;
+
+            std::vector<std::uint8_t> contents(static_cast<std::size_t>(capacity) * 4);
+            for(std::size_t i = 0; i < contents.size(); i++) {
+                contents[i] = static_cast<std::uint8_t>(i * 13);
+            }
+
+            WHEN("more bytes are produced than the pipe holds") {
+                for(std::size_t i = 0; i < contents.size(); i += 1000) {
+                    source.produce(plumbing::span<const std::uint8_t> {
+                        contents.data() + i, std::min<std::size_t>(1000, contents.size() - i)
+                    });
+                }
+
+                THEN("the sink must pause, and write everything as the pipe drains") {
+                    REQUIRE(sink.paused());
+                    REQUIRE_FALSE(source.writable());
+                    REQUIRE(sink.pending() >= 4096);
+
+                    ::fcntl(ends[0], F_SETFL, ::fcntl(ends[0], F_GETFL) | O_NONBLOCK);
+                    std::vector<std::uint8_t> read;
+                    std::uint8_t buffer[4096];
+                    REQUIRE(process_until(loop, [&] {
+                        const auto count = ::read(ends[0], buffer, sizeof(buffer));
+                        if(count > 0) read.insert(read.end(), buffer, buffer + count);
+                        return read.size() == contents.size();
+                    }));
+
+                    REQUIRE(read == contents);
+                    REQUIRE(sink.pending() == 0);
+                    REQUIRE_FALSE(sink.paused());
+                    REQUIRE(source.writable());
+                }
+            }
+        }
+
+        ::close(ends[0]);
+        ::close(ends[1]);
+    }
+
+    GIVEN("a socket pair with a sink on one end and a source on the other") {
+        int ends[2];
+        REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, ends) == 0);
+
+        {
+            plumbing::source<std::uint8_t> input;
+            plumbing::descriptor_sink writer { events, ends[0] };
+            plumbing::descriptor_source reader { events, ends[1], 1024 };
+            keeper<std::uint8_t> output;
+            input >> writer;
+            reader >> output;
+
+            WHEN("bytes are produced into the sink") {
+                std::vector<std::uint8_t> contents(100000);
+                for(std::size_t i = 0; i < contents.size(); i++) {
+                    contents[i] = static_cast<std::uint8_t>(i * 31);
+                }
+
+                for(std::size_t i = 0; i < contents.size(); i += 5000) {
+                    input.produce(plumbing::span<const std::uint8_t> { contents.data() + i, 5000 });
+                }
+
+                THEN("the source must emit all of them, in order") {
+                    REQUIRE(process_until(loop, [&] { return output.elements.size() == contents.size(); }));
+                    REQUIRE(output.elements == contents);
+                }
+            }
+        }
+
+        ::close(ends[0]);
+        ::close(ends[1]);
+    }
+}
+
+SCENARIO("aggregators fold elements incrementally", "[plumbing]") {
+    GIVEN("sums, counts, minima and maxima") {
+        plumbing::aggregators::sum<int> sum;
+        plumbing::aggregators::count<int> count;
+        plumbing::aggregators::minimum<int> minimum;
+        plumbing::aggregators::maximum<int> maximum;
+
+        THEN("empty aggregates must have neutral results") {
+            REQUIRE(sum.result() == 0);
+            REQUIRE(count.result() == 0);
+            REQUIRE_FALSE(minimum.result());
+            REQUIRE_FALSE(maximum.result());
+        }
+
+        WHEN("elements are added and other aggregates merged") {
+            for(int value : { 4, -2, 9 }) {
+                sum.add(value);
+                count.add(value);
+                minimum.add(value);
+            }
+
+            plumbing::aggregators::maximum<int> other;
+            other.add(12);
+            maximum.add(3);
+            maximum.merge(other);
+
+            THEN("their results must account for every element") {
+                REQUIRE(sum.result() == 11);
+                REQUIRE(count.result() == 3);
+                REQUIRE(minimum.result() == -2);
+                REQUIRE(maximum.result() == 12);
+            }
+        }
+    }
+
+    GIVEN("a quantile sketch") {
+        plumbing::aggregators::quantiles<double> sketch { 0.01 };
+
+        THEN("it must estimate nothing while empty") {
+            REQUIRE(std::isnan(sketch.quantile(0.5)));
+        }
+
+        WHEN("values from 1 to 10000 are added across two merged sketches") {
+            plumbing::aggregators::quantiles<double> other { 0.01 };
+            for(int i = 1; i <= 10000; i++) {
+                (i % 2 ? sketch : other).add(i);
+            }
+            sketch.merge(other);
+
+            THEN("its estimates must be within the relative accuracy") {
+                REQUIRE(sketch.count() == 10000);
+                for(double q : { 0.0, 0.5, 0.9, 0.99, 1.0 }) {
+                    const double exact = 1 + q * 9999;
+                    REQUIRE(std::abs(sketch.quantile(q) - exact) <= 0.01 * exact + 1);
+                }
+            }
+        }
+
+        THEN("it must refuse negative or non-finite values and sketches of another accuracy") {
+            REQUIRE_THROWS_AS(sketch.add(-1), std::domain_error);
+            REQUIRE_THROWS_AS(sketch.add(std::numeric_limits<double>::quiet_NaN()), std::domain_error);
+            REQUIRE_THROWS_AS(sketch.add(std::numeric_limits<double>::infinity()), std::domain_error);
+            REQUIRE(sketch.count() == 0);
+            REQUIRE_THROWS_AS(sketch.merge(plumbing::aggregators::quantiles<double> { 0.05 }), std::invalid_argument);
+        }
+    }
+}
+
+SCENARIO("windowed stages aggregate elements over event loop time", "[plumbing]") {
+    fugax::event_loop loop;
+    plumbing::source<int> source;
+
+    GIVEN("a tumbling window counting elements every 1000 time units") {
+        plumbing::tumbling_window<int, plumbing::aggregators::count<int>> window { loop, 1000 };
+        element_recorder<std::size_t> sink;
+        source >> window >> sink;
+
+        WHEN("elements arrive across several windows") {
+            source.produce(std::vector<int> { 1, 2, 3 });
+            loop.process(500);
+            source.produce(4);
+            loop.process(1000);
+            source.produce(std::vector<int> { 5, 6 });
+            loop.process(2000);
+            loop.process(3000);
+
+            THEN("one count must be emitted per window, including empty ones") {
+                REQUIRE(sink.elements == std::vector<std::size_t> { 4, 2, 0 });
+            }
+        }
+    }
+
+    GIVEN("a sliding window reporting the maximum of the last 3000 time units every 1000") {
+        plumbing::sliding_window<int, plumbing::aggregators::maximum<int>> window { loop, 3000, 1000 };
+        element_recorder<std::optional<int>> sink;
+        source >> window >> sink;
+
+        WHEN("elements arrive over time") {
+            source.produce(7);
+            loop.process(1000);
+            source.produce(3);
+            loop.process(2000);
+            loop.process(3000);
+            loop.process(4000);
+            loop.process(5000);
+            loop.process(6000);
+
+            THEN("each element must count in the windows that cover it") {
+                REQUIRE(sink.elements == std::vector<std::optional<int>> { 7, 7, 7, 3, std::nullopt, std::nullopt });
+            }
+        }
+
+        THEN("its width must be a multiple of its step") {
+            REQUIRE_THROWS_AS((plumbing::sliding_window<int, plumbing::aggregators::sum<int>> { loop, 1000, 300 }), std::invalid_argument);
+        }
+    }
+
+    GIVEN("a session window summing elements separated by less than 100 time units") {
+        plumbing::session_window<int, plumbing::aggregators::sum<int>> window { loop, 100 };
+        element_recorder<int> sink;
+        source >> window >> sink;
+
+        WHEN("two bursts of elements arrive") {
+            source.produce(1);
+            loop.process(50);
+            source.produce(2);
+            loop.process(120);
+            source.produce(3);
+            loop.process(300);
+            source.produce(std::vector<int> { 10, 20 });
+            loop.process(350);
+
+            THEN("one sum must be emitted per burst, after its gap") {
+                REQUIRE(sink.elements == std::vector<int> { 6 });
+                loop.process(500);
+                REQUIRE(sink.elements == std::vector<int> { 6, 30 });
+            }
+        }
+    }
+}
+
+SCENARIO("framers cut byte streams into frames without copying them", "[plumbing]") {
+    plumbing::source<std::uint8_t> source;
+    frame_recorder sink;
+
+    GIVEN("a delimited framer") {
+        plumbing::delimited_framer framer { '\n', 32 };
+        source >> framer >> sink;
+
+        WHEN("a chunk holding whole lines is consumed") {
+            const std::string text = "first\nsecond\n\nthird";
+            source.produce(bytes(text));
+
+            THEN("its lines must be emitted as a single chunk of views into it") {
+                REQUIRE(sink.chunks == 1);
+                REQUIRE(sink.frames == std::vector<std::string> { "first", "second", "" });
+                REQUIRE(sink.addresses[0] == bytes(text).data());
+                REQUIRE(sink.addresses[1] == bytes(text).data() + 6);
+                REQUIRE(framer.pending() == 5);
+            }
+
+            AND_WHEN("the rest of the straddling line arrives in later chunks") {
+                const std::string middle = "-and-";
+                const std::string last = "a-half\nfourth\n";
+                source.produce(bytes(middle));
+                source.produce(bytes(last));
+
+                THEN("only that line must have been reassembled") {
+                    REQUIRE(sink.frames == std::vector<std::string> { "first", "second", "", "third-and-a-half", "fourth" });
+                    REQUIRE(sink.addresses[4] == bytes(last).data() + 7);
+                    REQUIRE(framer.pending() == 0);
+                }
+            }
+        }
+
+        WHEN("a line longer than the maximum frame length is consumed") {
+            const std::string text = "0123456789abcdefghij0123456789abcdefghij";
+
+            THEN("it must be refused") {
+                REQUIRE_THROWS_AS(source.produce(bytes(text)), std::length_error);
+                REQUIRE(framer.pending() == 0);
+            }
+        }
+    }
+
+    GIVEN("a delimited framer with a small maximum frame length") {
+        plumbing::delimited_framer framer { '\n', 8 };
+        source >> framer >> sink;
+
+        WHEN("a line straddling two chunks turns out to be too long") {
+            source.produce(bytes("abcdef"s));
+
+            THEN("it must be refused, and the framer must recover with the next chunk") {
+                REQUIRE_THROWS_AS(source.produce(bytes("ghij\nok\n"s)), std::length_error);
+                REQUIRE(framer.pending() == 0);
+
+                source.produce(bytes("next\n"s));
+                REQUIRE(sink.frames == std::vector<std::string> { "next" });
+                REQUIRE(framer.pending() == 0);
+            }
+        }
+
+        WHEN("a chunk holds whole lines before a line that is too long") {
+            source.produce(bytes("a"s));
+
+            THEN("the lines before it must be emitted before it is refused") {
+                REQUIRE_THROWS_AS(source.produce(bytes("b\ncd\nefghijklm\nxy\n"s)), std::length_error);
+                REQUIRE(sink.frames == std::vector<std::string> { "ab", "cd" });
+                REQUIRE(framer.pending() == 0);
+            }
+        }
+    }
+
+    GIVEN("a fixed-size framer") {
+        plumbing::fixed_framer framer { 4 };
+        source >> framer >> sink;
+
+        WHEN("chunks that do not align with frames are consumed") {
+            source.produce(bytes("abcdef"s));
+            source.produce(bytes("gh"s));
+            source.produce(bytes("ijklmn"s));
+
+            THEN("every whole frame must be emitted") {
+                REQUIRE(sink.frames == std::vector<std::string> { "abcd", "efgh", "ijkl" });
+                REQUIRE(framer.pending() == 2);
+            }
+        }
+    }
+
+    GIVEN("a length-prefixed framer with two-byte prefixes") {
+        plumbing::length_prefixed_framer framer { 2, 300 };
+        source >> framer >> sink;
+
+        WHEN("frames are consumed with a prefix split across chunks") {
+            const std::string first = "\x00\x03one\x00\x00\x00"s;
+            const std::string second = "\x05three\x01"s;
+            source.produce(bytes(first));
+            source.produce(bytes(second));
+
+            THEN("the frames must be emitted without their prefixes") {
+                REQUIRE(sink.frames == std::vector<std::string> { "one", "", "three" });
+                REQUIRE(sink.addresses[0] == bytes(first).data() + 2);
+                REQUIRE(framer.pending() == 1);
+            }
+        }
+
+        WHEN("a prefix announces a frame longer than the maximum") {
+            THEN("it must be refused") {
+                REQUIRE_THROWS_AS(source.produce(bytes("\xff\xff"s)), std::length_error);
+            }
+
+            AND_WHEN("the prefix is split across chunks") {
+                source.produce(bytes("\xff"s));
+
+                THEN("it must be refused, and the framer must recover with the next chunk") {
+                    REQUIRE_THROWS_AS(source.produce(bytes("\xff"s)), std::length_error);
+                    REQUIRE(framer.pending() == 0);
+
+                    source.produce(bytes("\x00\x02ok"s));
+                    REQUIRE(sink.frames == std::vector<std::string> { "ok" });
+                }
+            }
+        }
+    }
+}
@@ -64,10 +64,11 @@ public:
         emplace(std::move(object));
     }
 
-    void emplace(auto && ...args) {
+    template<class ...T_args>
+    void emplace(T_args && ...args) {
         if(count == capacity) grow();
         queue[pos(head + count++)]
-            .construct(std::forward<decltype(args)>(args)...);
+            .construct(std::forward<T_args>(args)...);
     }
 
     T_object pop() {
@@ -1,53 +1,223 @@
-#ifndef POOL_ALLOCATOR_HPP
-#define POOL_ALLOCATOR_HPP
+#ifndef UTILS_POOL_ALLOCATOR_HPP
+#define UTILS_POOL_ALLOCATOR_HPP
 
-#include "object-pool.hpp"
+#include <array>
+#include <cstddef>
+#include <new>
 
-template<class T, std::size_t log_factor = 3>
-struct pool_allocator {
-    
-    using value_type = T;
-    using reference = T&;
-    using const_reference = const T&;
-    using pointer = T*;
-    using const_pointer = const T*;
-    using size_type = std::size_t;
-    using difference_type = std::ptrdiff_t;
-    
-    static object_pool<T, log_factor> pool;
-
-    pool_allocator() {  };
-    
-    template<class T_other, std::size_t log_factor_other = log_factor>
-    pool_allocator(const pool_allocator<T_other, log_factor_other>& other) {  }
-    
-    T *allocate(std::size_t len) {
-        if(len > 1) throw std::bad_alloc();
-        return pool.allocate();
-    }
-
-    void deallocate(T *obj, std::size_t len) {
-        pool.deallocate(obj);
-    }
-    
-    void construct(pointer p, const_reference val) {
-        new(p) T(val);
-    }
-    
-    void destroy(pointer p) {
-        p->~T();
-    }
-    
-    size_type max_size() const noexcept { return 1; }
-
-    template<class T_other, std::size_t log_factor_other = log_factor>
-    struct rebind {
-        using other = pool_allocator<T_other, log_factor_other>;
+namespace utils {
+
+/**
+ * @brief A set of per-thread free lists of memory blocks, one for each size
+ * class.
+ * @details Requested sizes are rounded up to a multiple of `granularity`, the
+ * size class; blocks of each class are recycled through a free list owned by
+ * the calling thread, so that, once the pool is warmed up, allocating and
+ * deallocating blocks does not touch the global allocator. Blocks can be
+ * freely deallocated in a thread other than the one that allocated them; they
+ * will then be recycled by the deallocating thread. Each free list holds at
+ * most `max_free` blocks, and further blocks go back to the global allocator,
+ * so a thread that only frees blocks allocated elsewhere cannot hoard memory.
+ * Blocks freed after the calling thread's free lists have been destroyed,
+ * e.g. by thread-local destructors, go straight to the global allocator.
+ * Requests larger than `max_size` or over-aligned are forwarded to the global
+ * allocator.
+ */
+class size_class_pool {
+public:
+    /**
+     * @brief The size difference between two consecutive size classes
+     */
+    static constexpr std::size_t granularity = 16;
+
+    /**
+     * @brief The size of the largest size class
+     */
+    static constexpr std::size_t max_size = 512;
+
+    /**
+     * @brief The number of size classes
+     */
+    static constexpr std::size_t class_count = max_size / granularity;
+
+    /**
+     * @brief The maximum number of blocks in each free list
+     */
+    static constexpr std::size_t max_free = 256;
+
+    /**
+     * @brief Allocates a memory block of at least `size` bytes, recycling a
+     * free block of the calling thread if there is one.
+     * @param size The requested size
+     * @param alignment The requested alignment
+     * @return A pointer to the allocated block
+     */
+    static void *allocate(std::size_t size, std::size_t alignment) {
+        if(!is_pooled(size, alignment)) {
+            return ::operator new(size, std::align_val_t { alignment });
+        }
+
+        const auto index = class_of(size);
+        if(lists_destroyed) {
+            return ::operator new((index + 1) * granularity);
+        }
+
+        auto &lists = current_lists;
+        if(auto *block = lists.heads[index]) {
+            lists.heads[index] = block->next;
+            lists.counts[index]--;
+            return block;
+        }
+
+        return ::operator new((index + 1) * granularity);
+    }
+
+    /**
+     * @brief Returns a memory block to the calling thread's free list, or to
+     * the global allocator if that list is full.
+     * @param block A block previously allocated with the same size and
+     * alignment
+     * @param size The size requested upon allocation
+     * @param alignment The alignment requested upon allocation
+     */
+    static void deallocate(void *block, std::size_t size, std::size_t alignment) noexcept {
+        if(!is_pooled(size, alignment)) {
+            ::operator delete(block, std::align_val_t { alignment });
+            return;
+        }
+
+        const auto index = class_of(size);
+        if(lists_destroyed) {
+            ::operator delete(block);
+            return;
+        }
+
+        auto &lists = current_lists;
+        if(lists.counts[index] >= max_free) {
+            ::operator delete(block);
+            return;
+        }
+
+        lists.heads[index] = new(block) free_block { lists.heads[index] };
+        lists.counts[index]++;
+    }
+
+    /**
+     * @brief Returns how many free blocks of a given size are available in the
+     * calling thread.
+     * @param size The size being queried
+     * @return The number of blocks in the corresponding free list
+     */
+    static std::size_t available(std::size_t size) noexcept {
+        if(size > max_size || lists_destroyed) return 0;
+        return current_lists.counts[class_of(size)];
+    }
+
+private:
+    /**
+     * @brief A free block; while in a free list, each block stores a pointer
+     * to the next one
+     */
+    struct free_block {
+        free_block *next;
     };
+
+    /**
+     * @brief The free lists of a single thread; upon thread exit, all blocks
+     * in them are returned to the global allocator
+     * @note Being thread-local, the lists are zero-initialised, which leaves
+     * them empty
+     */
+    struct free_lists {
+        std::array<free_block *, class_count> heads;
+        std::array<std::size_t, class_count> counts;
+
+        ~free_lists() {
+            lists_destroyed = true;
+            for(auto *head : heads) {
+                while(head) {
+                    auto *next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief Whether the free lists of the calling thread have been
+     * destroyed; being trivially destructible, it can still be read by
+     * destructors of other thread-local objects that run later, e.g. ones
+     * releasing pooled objects
+     */
+    static inline thread_local bool lists_destroyed = false;
+
+    /**
+     * @brief The free lists of the calling thread
+     */
+    static inline thread_local free_lists current_lists;
+
+    /**
+     * @brief Returns whether a request is served by the pool
+     */
+    static constexpr bool is_pooled(std::size_t size, std::size_t alignment) noexcept {
+        return size <= max_size && alignment <= alignof(std::max_align_t);
+    }
+
+    /**
+     * @brief Maps a size to the index of its size class
+     */
+    static constexpr std::size_t class_of(std::size_t size) noexcept {
+        return size == 0 ? 0 : (size - 1) / granularity;
+    }
 };
 
-template<class T, std::size_t log_factor>
-object_pool<T, log_factor> pool_allocator<T, log_factor>::pool;
+/**
+ * @brief A standard allocator backed by the `size_class_pool`; objects of
+ * any type up to `size_class_pool::max_size` bytes, e.g. those created
+ * through `std::allocate_shared`, are recycled through per-thread free lists
+ * @tparam T The allocated type
+ */
+template<class T>
+struct pool_allocator {
+    using value_type = T;
+
+    constexpr pool_allocator() noexcept = default;
+
+    template<class T_other>
+    constexpr pool_allocator(const pool_allocator<T_other> &) noexcept {  }
+
+    /**
+     * @brief Allocates storage for `count` objects of type `T`
+     * @param count The number of objects
+     * @return A pointer to the allocated storage
+     */
+    T *allocate(std::size_t count) {
+        return static_cast<T *>(
+            size_class_pool::allocate(count * sizeof(T), alignof(T))
+        );
+    }
+
+    /**
+     * @brief Deallocates storage previously obtained from `allocate()`
+     * @param pointer The storage to deallocate
+     * @param count The number of objects, as supplied to `allocate()`
+     */
+    void deallocate(T *pointer, std::size_t count) noexcept {
+        size_class_pool::deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    template<class T_other>
+    friend constexpr bool operator==(const pool_allocator &, const pool_allocator<T_other> &) noexcept {
+        return true;
+    }
+
+    template<class T_other>
+    friend constexpr bool operator!=(const pool_allocator &, const pool_allocator<T_other> &) noexcept {
+        return false;
+    }
+};
 
+} /* namespace utils */
 
-#endif /* POOL_ALLOCATOR_HPP */
\ No newline at end of file
+#endif /* UTILS_POOL_ALLOCATOR_HPP */
@@ -2,6 +2,7 @@
 #define UTILS_STORAGE_FOR_HPP
 
 #include <new>
+#include <utility>
 
 namespace utils {
 
@@ -10,13 +11,18 @@ class storage_for {
     union storage_space {
         T_object object;
         struct empty_storage {  } empty;
+        storage_space() : empty {  } {  }
+        template<class ...T_args>
+        storage_space(std::in_place_t, T_args && ...args) :
+            object { std::forward<T_args>(args)... } {  }
         ~storage_space() {  }
     } storage;
 
 public:
-    storage_for() : storage { .empty {  } } {  }
-    storage_for(auto && ...args) : 
-        storage { T_object { std::forward<decltype(args)>(args)... } }
+    storage_for() : storage {  } {  }
+    template<class ...T_args>
+    storage_for(T_args && ...args) : 
+        storage { std::in_place, std::forward<T_args>(args)... }
         {  }
     ~storage_for() = default;
     storage_for(const storage_for<T_object> &) = delete;
@@ -24,9 +30,10 @@ public:
     storage_for &operator=(const storage_for<T_object> &) = delete;
     storage_for &operator=(storage_for<T_object> &&) = delete;
 
-    T_object *construct(auto && ...args) {
+    template<class ...T_args>
+    T_object *construct(T_args && ...args) {
         return new (&storage.object)
-            T_object { std::forward<decltype(args)>(args)... };
+            T_object { std::forward<T_args>(args)... };
     }
 
     storage_for<T_object> *destruct() noexcept { 